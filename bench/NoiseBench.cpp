@@ -0,0 +1,60 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+
+#include "Perlin.hpp"
+
+#define BENCH_W       1024    // Width of the benchmarked grid
+#define BENCH_H       1024    // Height of the benchmarked grid
+#define BENCH_RUNS    5       // Runs per case; the fastest is reported
+#define BENCH_OCTAVES 6       // Same terrain settings as the editor's generator
+#define BENCH_BIAS    2.0
+#define BENCH_SCALE   48.0
+
+/** Time the fastest of several runs of one kernel, leaving the last grid generated in output */
+double timeNoise(const unsigned char &interp, const unsigned char &kernel, const unsigned int &threads, std::vector<double> &output) {
+    double best = 0.0;
+    for (int i = 0; i < BENCH_RUNS; i++) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        output = getNoiseBuffer(BENCH_W, BENCH_H, BENCH_OCTAVES, BENCH_BIAS, BENCH_SCALE, interp, kernel, threads);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || seconds < best) {best = seconds;}
+    }
+    return best;
+}
+
+/** Compares the Perlin & simplex kernels on the same grid: throughput (best of several runs, single-threaded & across every core) and value & roughness statistics
+ * Everything is deterministic, so the statistics only change when a kernel does    */
+int main() {
+    struct {
+        std::string Name;
+        unsigned char Interp, Kernel;
+    } cases[4] = {
+        {"perlin (linear)", PERLIN_INTERP_LINEAR, NOISE_KERNEL_PERLIN},
+        {"perlin (cubic)", PERLIN_INTERP_CUBIC, NOISE_KERNEL_PERLIN},
+        {"perlin (quintic)", PERLIN_INTERP_QUINTIC, NOISE_KERNEL_PERLIN},
+        {"simplex", PERLIN_INTERP_QUINTIC, NOISE_KERNEL_SIMPLEX}
+    };
+
+    std::cout << BENCH_W << " x " << BENCH_H << " cells, " << BENCH_OCTAVES << " octaves, best of " << BENCH_RUNS << " runs\n\n";
+    std::cout << std::left << std::setw(18) << "kernel" << std::right << std::setw(12) << "1 thread" << std::setw(12) << "all cores"
+              << std::setw(9) << "min" << std::setw(9) << "max" << std::setw(9) << "mean" << std::setw(9) << "stddev" << std::setw(11) << "roughness" << "\n";
+
+    std::vector<double> buffer;
+    std::cout << std::fixed;
+    for (int i = 0; i < 4; i++) {
+        const double single = timeNoise(cases[i].Interp, cases[i].Kernel, 1, buffer);
+        const double all = timeNoise(cases[i].Interp, cases[i].Kernel, 0, buffer);
+        const NoiseStats stats = getNoiseStats(buffer, BENCH_W);
+
+        // Throughput in millions of cells per second
+        const double cells = (double)BENCH_W * BENCH_H / 1000000.0;
+        std::cout << std::left << std::setw(18) << cases[i].Name << std::right << std::setprecision(2)
+                  << std::setw(8) << cells / single << " M/s" << std::setw(8) << cells / all << " M/s" << std::setprecision(4)
+                  << std::setw(9) << stats.Min << std::setw(9) << stats.Max << std::setw(9) << stats.Mean << std::setw(9) << stats.StdDev << std::setw(11) << stats.Roughness << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <SDL2/SDL.h>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include "Raster.hpp"
+#include "PresetColors.hpp"
+
+#define BENCH_W      1280    // Size of the frame, the same as the editor's window
+#define BENCH_H      720
+#define BENCH_FRAMES 200     // Frames per path; the average is reported
+
+/** Everything one frame draws: thick lines at a few angles & in every thickness mode, a filled circle and a circle outline */
+void drawScene(Raster &raster) {
+    raster.drawThickLine(0, BENCH_H / 2, BENCH_W - 1, BENCH_H / 2, 9, LINE_THICKNESS_MIDDLE, PresetColors[COLOR_LIME]);
+    raster.drawThickLine(100, 50, 1100, 650, 7, LINE_THICKNESS_DRAW_CLOCKWISE, PresetColors[COLOR_ORANGE]);
+    raster.drawThickLine(1200, 80, 300, 700, 5, LINE_THICKNESS_DRAW_COUNTERCLOCKWISE, PresetColors[COLOR_CYAN]);
+    raster.fillCircle(BENCH_W / 2, BENCH_H / 2, 200, PresetColors[COLOR_TEAL]);
+    raster.drawCircle(BENCH_W / 2, BENCH_H / 2, 100, PresetColors[COLOR_WHITE]);
+}
+
+/** Time one way of drawing the scene
+ * @returns Average microseconds per frame    */
+double timeFrames(SDL_Renderer* renderer, const std::function<void()> &frame) {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_RenderClear(renderer);
+        frame();
+        SDL_RenderFlush(renderer);
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / BENCH_FRAMES;
+}
+
+/** Compares drawing thick lines & circles through Raster (CPU rasterisation, one upload & one copy per frame) with sending the same pixels to SDL,
+ * either as one SDL_RenderDrawPoint() per pixel (how RenderWindow used to draw them) or as one SDL_RenderDrawPoints() per color
+ * Runs on SDL's software renderer so it needs no display; a GPU renderer pays more per draw call, which only favours Raster further    */
+int main() {
+    if (SDL_Init(0) < 0) {
+        std::cout << "Failed to initialize SDL2\nERROR: " << SDL_GetError() << "\n";
+        return 1;
+    }
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, BENCH_W, BENCH_H, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* renderer = surface != NULL ? SDL_CreateSoftwareRenderer(surface) : NULL;
+    SDL_Texture* texture = renderer != NULL ? SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, BENCH_W, BENCH_H) : NULL;
+    if (texture == NULL) {
+        std::cout << "Failed to create the benchmark renderer\nERROR: " << SDL_GetError() << "\n";
+        SDL_Quit();
+        return 1;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+    // The pixels of one frame grouped by color, for the SDL paths
+    Raster raster(BENCH_W, BENCH_H);
+    drawScene(raster);
+    std::vector<Uint32> colors;
+    std::vector<std::vector<SDL_Point>> points;
+    for (int y = 0; y < BENCH_H; y++) {
+        for (int x = 0; x < BENCH_W; x++) {
+            const Uint32 pixel = raster.getPixels()[(unsigned long int)y * BENCH_W + x];
+            if (pixel == 0) {continue;}
+            unsigned long int c = 0;
+            while (c < colors.size() && colors[c] != pixel) {c++;}
+            if (c == colors.size()) {
+                colors.push_back(pixel);
+                points.emplace_back();
+            }
+            points[c].push_back({x, y});
+        }
+    }
+    unsigned long int pixels = 0;
+    for (unsigned long int c = 0; c < points.size(); c++) {pixels += points[c].size();}
+    raster.clearDirty();
+
+    const double rasterTime = timeFrames(renderer, [&]() {
+        drawScene(raster);
+        const SDL_Rect dirty = raster.getDirty();
+        SDL_UpdateTexture(texture, &dirty, raster.getPixels() + (unsigned long int)dirty.y * BENCH_W + dirty.x, raster.getPitch());
+        SDL_RenderCopy(renderer, texture, &dirty, &dirty);
+        raster.clearDirty();
+    });
+    const double pointTime = timeFrames(renderer, [&]() {
+        for (unsigned long int c = 0; c < points.size(); c++) {
+            SDL_SetRenderDrawColor(renderer, colors[c] >> 16 & 0xFF, colors[c] >> 8 & 0xFF, colors[c] & 0xFF, colors[c] >> 24);
+            for (unsigned long int i = 0; i < points[c].size(); i++) {SDL_RenderDrawPoint(renderer, points[c][i].x, points[c][i].y);}
+        }
+    });
+    const double batchTime = timeFrames(renderer, [&]() {
+        for (unsigned long int c = 0; c < points.size(); c++) {
+            SDL_SetRenderDrawColor(renderer, colors[c] >> 16 & 0xFF, colors[c] >> 8 & 0xFF, colors[c] & 0xFF, colors[c] >> 24);
+            SDL_RenderDrawPoints(renderer, points[c].data(), points[c].size());
+        }
+    });
+
+    std::cout << BENCH_W << " x " << BENCH_H << " frame, " << pixels << " pixels drawn, average of " << BENCH_FRAMES << " frames\n\n" << std::fixed << std::setprecision(1);
+    std::cout << std::left << std::setw(34) << "path" << std::right << std::setw(12) << "us/frame" << std::setw(12) << "draw calls" << "\n";
+    std::cout << std::left << std::setw(34) << "Raster (upload + copy)" << std::right << std::setw(12) << rasterTime << std::setw(12) << 2 << "\n";
+    std::cout << std::left << std::setw(34) << "SDL_RenderDrawPoint per pixel" << std::right << std::setw(12) << pointTime << std::setw(12) << pixels << "\n";
+    std::cout << std::left << std::setw(34) << "SDL_RenderDrawPoints per color" << std::right << std::setw(12) << batchTime << std::setw(12) << points.size() << "\n";
+
+    SDL_DestroyTexture(texture);
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(surface);
+    SDL_Quit();
+    return 0;
+}
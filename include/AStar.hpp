@@ -4,6 +4,8 @@
 #include <cmath>
 #include <vector>
 
+#include "AStarRecorder.hpp"
+
 #define ASTAR_MOVE_NOBOUND 0
 #define ASTAR_MOVE_NOPHASE 1
 #define ASTAR_MOVE_NOTOUCH 2
@@ -15,6 +17,18 @@ class AStar_Grid {
             double totalCost = 0.0, fromCost = 0.0, toCost = 0.0;
         };
 
+#if ASTAR_RECORD
+        static AStar_Recorder*& recorder() {
+            static AStar_Recorder* output = NULL;
+            return output;
+        }
+        static void recordBegin(const std::vector<std::vector<double>> &grid) {if (recorder() != NULL) {recorder()->begin(grid.empty() ? 0 : grid[0].size(), grid.size());}}
+        static void record(const unsigned char &type, const unsigned long int &row, const unsigned long int &col) {if (recorder() != NULL) {recorder()->record(type, row, col);}}
+#else
+        static void recordBegin(const std::vector<std::vector<double>> &grid) {}
+        static void record(const unsigned char &type, const unsigned long int &row, const unsigned long int &col) {}
+#endif
+
         static bool isValid(const std::vector<std::vector<double>> &grid, const unsigned long int &row, const unsigned long int &col) {return row < grid.size() && col < grid.at(row).size();}
         static bool isDestination(const std::pair<unsigned long int, unsigned long int> &dst, const unsigned long int &row, const unsigned long int &col) {return row == dst.first && col == dst.second;}
 
@@ -67,6 +81,7 @@ class AStar_Grid {
                     const double totalCost = fromCost + toCost;
 
                     if (cellDetails.at(row + rowStep).at(col + colStep).totalCost == __FLT_MAX__ || cellDetails.at(row + rowStep).at(col + colStep).totalCost > totalCost) {
+                        if (cellDetails.at(row + rowStep).at(col + colStep).totalCost != __FLT_MAX__) {AStar_Grid::record(ASTAR_EVENT_REOPEN, row + rowStep, col + colStep);}
                         openList.emplace_back(std::make_pair(totalCost, std::make_pair(row + rowStep, col + colStep)));
 
                         cellDetails[row + rowStep][col + colStep].totalCost = totalCost;
@@ -95,6 +110,7 @@ class AStar_Grid {
                     const double totalCost = fromCost + toCost;
 
                     if (cellDetails.at(row + rowStep).at(col + colStep).totalCost == __FLT_MAX__ || cellDetails.at(row + rowStep).at(col + colStep).totalCost > totalCost) {
+                        if (cellDetails.at(row + rowStep).at(col + colStep).totalCost != __FLT_MAX__) {AStar_Grid::record(ASTAR_EVENT_REOPEN, row + rowStep, col + colStep);}
                         openList.emplace_back(std::make_pair(totalCost, std::make_pair(row + rowStep, col + colStep)));
 
                         cellDetails[row + rowStep][col + colStep].totalCost = totalCost;
@@ -123,6 +139,7 @@ class AStar_Grid {
                     const double totalCost = fromCost + toCost;
 
                     if (cellDetails.at(row + rowStep).at(col + colStep).totalCost == __FLT_MAX__ || cellDetails.at(row + rowStep).at(col + colStep).totalCost > totalCost) {
+                        if (cellDetails.at(row + rowStep).at(col + colStep).totalCost != __FLT_MAX__) {AStar_Grid::record(ASTAR_EVENT_REOPEN, row + rowStep, col + colStep);}
                         openList.emplace_back(std::make_pair(totalCost, std::make_pair(row + rowStep, col + colStep)));
 
                         cellDetails[row + rowStep][col + colStep].totalCost = totalCost;
@@ -137,9 +154,18 @@ class AStar_Grid {
         }
     
     public:
+        /** Have every search from now on report its expansions to a recorder (or to nothing if NULL)
+         * Does nothing unless built with ASTAR_RECORD    */
+        static void setRecorder(AStar_Recorder* recorder) {
+#if ASTAR_RECORD
+            AStar_Grid::recorder() = recorder;
+#endif
+        }
+
         static std::vector<std::pair<unsigned long int, unsigned long int>> cardinal(const std::vector<std::vector<double>> &grid, const std::pair<unsigned long int, unsigned long int> &src, const std::pair<unsigned long int, unsigned long int> &dst, const double &maxAscend, const double &maxDescend, const double &cardinalDistance = 1.0, const double &diagonalDistance = 1.41421356237309504880) {
             if (!AStar_Grid::isValid(grid, src.first, src.second) || !AStar_Grid::isValid(grid, dst.first, dst.second)) {return {src};}
             if (AStar_Grid::isDestination(dst, src.first, src.second)) {return {src};}
+            AStar_Grid::recordBegin(grid);
 
             std::vector<std::vector<bool>> closedList;
             std::vector<std::vector<AStar_Grid::Cell>> cellDetails;
@@ -174,6 +200,7 @@ class AStar_Grid {
                 openList.erase(openList.begin());
 
                 closedList[row][col] = true;
+                AStar_Grid::record(ASTAR_EVENT_EXPAND, row, col);
 
                 if (AStar_Grid::successorManhattan(grid, dst, closedList, openList, cellDetails, row, col, -1,  0, maxAscend, maxDescend, cardinalDistance, diagonalDistance)) {return AStar_Grid::getPath(dst, cellDetails);}
                 if (AStar_Grid::successorManhattan(grid, dst, closedList, openList, cellDetails, row, col,  1,  0, maxAscend, maxDescend, cardinalDistance, diagonalDistance)) {return AStar_Grid::getPath(dst, cellDetails);}
@@ -185,6 +212,7 @@ class AStar_Grid {
         static std::vector<std::pair<unsigned long int, unsigned long int>> diagonal(const std::vector<std::vector<double>> &grid, const std::pair<unsigned long int, unsigned long int> &src, const std::pair<unsigned long int, unsigned long int> &dst, const double &maxAscend, const double &maxDescend, const unsigned char &moveType = ASTAR_MOVE_NOBOUND, const double &cardinalDistance = 1.0, const double &diagonalDistance = 1.41421356237309504880) {
             if (!AStar_Grid::isValid(grid, src.first, src.second) || !AStar_Grid::isValid(grid, dst.first, dst.second)) {return {src};}
             if (AStar_Grid::isDestination(dst, src.first, src.second)) {return {src};}
+            AStar_Grid::recordBegin(grid);
 
             std::vector<std::vector<bool>> closedList;
             std::vector<std::vector<AStar_Grid::Cell>> cellDetails;
@@ -219,6 +247,7 @@ class AStar_Grid {
                 openList.erase(openList.begin());
 
                 closedList[row][col] = true;
+                AStar_Grid::record(ASTAR_EVENT_EXPAND, row, col);
 
                 if (AStar_Grid::successorDiagonal(grid, dst, closedList, openList, cellDetails, row, col, -1,  0, maxAscend, maxDescend, cardinalDistance, diagonalDistance, ASTAR_MOVE_NOBOUND)) {return AStar_Grid::getPath(dst, cellDetails);}
                 if (AStar_Grid::successorDiagonal(grid, dst, closedList, openList, cellDetails, row, col,  1,  0, maxAscend, maxDescend, cardinalDistance, diagonalDistance, ASTAR_MOVE_NOBOUND)) {return AStar_Grid::getPath(dst, cellDetails);}
@@ -234,6 +263,7 @@ class AStar_Grid {
         static std::vector<std::pair<unsigned long int, unsigned long int>> euclidean(const std::vector<std::vector<double>> &grid, const std::pair<unsigned long int, unsigned long int> &src, const std::pair<unsigned long int, unsigned long int> &dst, const double &maxAscend, const double &maxDescend, const unsigned char &moveType = ASTAR_MOVE_NOBOUND, const double &cardinalDistance = 1.0, const double &diagonalDistance = 1.41421356237309504880) {
             if (!AStar_Grid::isValid(grid, src.first, src.second) || !AStar_Grid::isValid(grid, dst.first, dst.second)) {return {src};}
             if (AStar_Grid::isDestination(dst, src.first, src.second)) {return {src};}
+            AStar_Grid::recordBegin(grid);
 
             std::vector<std::vector<bool>> closedList;
             std::vector<std::vector<AStar_Grid::Cell>> cellDetails;
@@ -268,6 +298,7 @@ class AStar_Grid {
                 openList.erase(openList.begin());
 
                 closedList[row][col] = true;
+                AStar_Grid::record(ASTAR_EVENT_EXPAND, row, col);
 
                 if (AStar_Grid::successorEuclidean(grid, dst, closedList, openList, cellDetails, row, col, -1,  0, maxAscend, maxDescend, cardinalDistance, diagonalDistance, ASTAR_MOVE_NOBOUND)) {return AStar_Grid::getPath(dst, cellDetails);}
                 if (AStar_Grid::successorEuclidean(grid, dst, closedList, openList, cellDetails, row, col,  1,  0, maxAscend, maxDescend, cardinalDistance, diagonalDistance, ASTAR_MOVE_NOBOUND)) {return AStar_Grid::getPath(dst, cellDetails);}
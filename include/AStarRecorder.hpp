@@ -0,0 +1,68 @@
+#ifndef ASTARRECORDER
+#define ASTARRECORDER
+
+#include <vector>
+#include <utility>
+
+// Build with -D ASTAR_RECORD=1 to have searches report to a recorder; otherwise the hooks compile to nothing
+#ifndef ASTAR_RECORD
+#define ASTAR_RECORD 0
+#endif
+
+#define ASTAR_EVENT_EXPAND 0    // A cell was taken off the open list & its neighbours looked at
+#define ASTAR_EVENT_REOPEN 1    // A cell already on the open list was found again through a cheaper path
+
+/** The order a search expanded & reopened cells in, kept in a buffer allocated once up front
+ * Every event is a single word (cell index & event type), so recording costs one store; events past the capacity are counted but dropped    */
+class AStar_Recorder {
+    private:
+        std::vector<unsigned long int> Events;
+        unsigned long int Count = 0;
+        unsigned long int Dropped = 0;
+        unsigned long int W = 0;
+        unsigned long int H = 0;
+        // Bumped by every begin() so views of the recording know when to refresh
+        unsigned long int Serial = 0;
+
+    public:
+        /** @param capacity Number of events kept per search    */
+        AStar_Recorder(const unsigned long int &capacity = 1 << 20) : Events(capacity) {}
+
+        /** Forget the last search & start recording one over a grid of the given size */
+        void begin(const unsigned long int &w, const unsigned long int &h) {
+            W = w;
+            H = h;
+            Count = 0;
+            Dropped = 0;
+            Serial++;
+        }
+        /** @param type Either ASTAR_EVENT_EXPAND or ASTAR_EVENT_REOPEN    */
+        void record(const unsigned char &type, const unsigned long int &row, const unsigned long int &col) {
+            if (Count < Events.size()) {Events[Count++] = (row * W + col) << 1 | type;}
+            else {Dropped++;}
+        }
+
+        unsigned long int getW() const {return W;}
+        unsigned long int getH() const {return H;}
+        unsigned long int getSerial() const {return Serial;}
+        unsigned long int getCapacity() const {return Events.size();}
+        /** @returns The number of events kept    */
+        unsigned long int getCount() const {return Count;}
+        /** @returns The number of events that did not fit    */
+        unsigned long int getDropped() const {return Dropped;}
+
+        unsigned char getType(const unsigned long int &i) const {return Events[i] & 1;}
+        /** @returns The row & column of event i    */
+        std::pair<unsigned long int, unsigned long int> getCell(const unsigned long int &i) const {
+            const unsigned long int cell = Events[i] >> 1;
+            return std::make_pair(cell / W, cell % W);
+        }
+        /** @returns The number of events of one type kept    */
+        unsigned long int countType(const unsigned char &type) const {
+            unsigned long int output = 0;
+            for (unsigned long int i = 0; i < Count; i++) {output += (Events[i] & 1) == type;}
+            return output;
+        }
+};
+
+#endif /* ASTARRECORDER */
@@ -0,0 +1,407 @@
+#ifndef BRUSH
+#define BRUSH
+
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+#include <functional>
+#include <unordered_map>
+#include <cmath>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define BRUSH_SHAPE_DIAMOND  0    // Every cell within radius steps (rows + columns) at full weight
+#define BRUSH_SHAPE_GAUSSIAN 1    // A disc fading out along a bell curve
+#define BRUSH_SHAPE_COSINE   2    // A disc fading out along half a cosine wave, flatter in the middle than a gaussian
+
+#define BRUSH_MODE_RAISE   0    // Add the strength (subtract if negative)
+#define BRUSH_MODE_SMOOTH  1    // Blend towards a gaussian blur of the area
+#define BRUSH_MODE_SHARPEN 2    // Push away from a gaussian blur of the area (unsharp masking)
+#define BRUSH_MODE_ERODE   3    // Blend towards the lowest neighbouring cell
+
+#define BRUSH_TILE_SIZE 32    // Width & height in cells of the blocks strokes keep their coverage in
+
+/** Edits a heightmap in place by stamping a precomputed kernel onto it, either once or swept along a stroke
+ * Kernels are built once per radius and stored as one run of columns per row, so a stamp only touches the cells under it: O(radius^2) no matter how big the grid is.
+ * Filtering modes run as separable row & column passes over each block a stroke reaches, vectorised with SSE2 when available, in scratch buffers reused between strokes    */
+class Brush {
+    public:
+        /** Block of cells (inclusive) a stamp changed; empty while FirstRow > LastRow */
+        struct Area {
+            int FirstRow = 0, FirstCol = 0;
+            int LastRow = -1, LastCol = -1;
+
+            bool isEmpty() const {return FirstRow > LastRow || FirstCol > LastCol;}
+            /** Grow to cover another area */
+            void merge(const Area &area) {
+                if (area.isEmpty()) {return;}
+                if (isEmpty()) {
+                    *this = area;
+                    return;
+                }
+                FirstRow = std::min(FirstRow, area.FirstRow);
+                FirstCol = std::min(FirstCol, area.FirstCol);
+                LastRow = std::max(LastRow, area.LastRow);
+                LastCol = std::max(LastCol, area.LastCol);
+            }
+        };
+
+    private:
+        struct Kernel {
+            // Column offsets of the run on each row, from row -radius to +radius
+            std::vector<int> SpanStart, SpanEnd;
+            // Weight of every cell of the (2 * radius + 1)^2 box, row-major
+            std::vector<double> Weights;
+        };
+
+        unsigned char Shape = BRUSH_SHAPE_DIAMOND;
+        unsigned char Mode = BRUSH_MODE_RAISE;
+        // Kernels[r] is the kernel of radius r for the current shape, built the first time it is used
+        std::vector<Kernel> Kernels;
+
+        std::function<void(const Area&)> BeforeChange;
+
+        // Stroke state: the last point applied & the samples collected since
+        bool Stroking = false;
+        bool StampStart = false;
+        int LastRow = 0, LastCol = 0;
+        std::vector<std::pair<int, int>> Samples;
+        // A block of the grid a stroke has reached, with the highest kernel weight on each of its cells (row-major, BRUSH_TILE_SIZE cells per row)
+        struct StrokeTile {
+            int Row = 0, Col = 0;
+            // Highest weight applied so far this stroke & reached so far this call
+            std::vector<double> Applied, Reached;
+            // What the filtering modes blend towards, taken before this call changed anything (row-major, as wide as the tile)
+            std::vector<double> Target;
+            bool Touched = false;
+        };
+        // Scratch space for applyStroke(), kept between calls & strokes so strokes don't allocate; the first TileCount tiles belong to the current stroke
+        std::vector<std::pair<int, int>> Centers;
+        std::vector<StrokeTile> Tiles;
+        unsigned long int TileCount = 0;
+        std::unordered_map<unsigned long int, unsigned long int> TileIndex;
+        std::vector<unsigned long int> Touched;
+        std::vector<Area> Changed;
+        // Scratch space for the filtering modes: the area plus a margin, after the row pass & after both passes
+        std::vector<double> Source, Rows, Filtered, Taps;
+
+        /** Get the kernel of the current shape for a radius, building it if needed */
+        const Kernel& getKernel(const int &radius) {
+            if ((int)Kernels.size() <= radius) {Kernels.resize(radius + 1);}
+            Kernel &kernel = Kernels[radius];
+            if (!kernel.Weights.empty()) {return kernel;}
+
+            const int size = radius * 2 + 1;
+            // Discs reach half a cell past the radius so their edges aren't flattened
+            const double edge = radius + 0.5, sigma = std::max(radius / 2.5, 0.5);
+            kernel.SpanStart.resize(size);
+            kernel.SpanEnd.resize(size);
+            kernel.Weights.assign((unsigned long int)size * size, 0.0);
+            for (int i = -radius; i <= radius; i++) {
+                const int reach = Shape == BRUSH_SHAPE_DIAMOND ? radius - std::abs(i) : std::min((int)std::sqrt(edge * edge - i * i), radius);
+                kernel.SpanStart[i + radius] = -reach;
+                kernel.SpanEnd[i + radius] = reach;
+                for (int j = -reach; j <= reach; j++) {
+                    const double distance = std::sqrt((double)(i * i + j * j));
+                    double weight = 1.0;
+                    if (Shape == BRUSH_SHAPE_GAUSSIAN) {weight = std::exp(-distance * distance / (2.0 * sigma * sigma));}
+                    else if (Shape == BRUSH_SHAPE_COSINE) {weight = 0.5 + 0.5 * std::cos(M_PI * distance / (radius + 1.0));}
+                    kernel.Weights[(unsigned long int)(i + radius) * size + j + radius] = weight;
+                }
+            }
+            return kernel;
+        }
+
+        /** One horizontal pass: every output cell is the weighted sum (or the minimum) of the 2 * margin + 1 input cells centered on it
+         * @param src First input row; row i holds w + 2 * margin cells starting at src + i * srcPitch
+         * @param dst First output row; row i holds w cells starting at dst + i * dstPitch    */
+        static void filterRows(const double* src, const int &srcPitch, double* dst, const int &dstPitch, const int &rows, const int &w, const double* taps, const int &margin, const bool &minimum) {
+            for (int i = 0; i < rows; i++) {
+                const double* in = src + (unsigned long int)i * srcPitch;
+                double* out = dst + (unsigned long int)i * dstPitch;
+                int j = 0;
+#if defined(__SSE2__)
+                for (; j + 2 <= w; j += 2) {
+                    __m128d acc = minimum ? _mm_loadu_pd(in + j) : _mm_setzero_pd();
+                    for (int k = 0; k <= margin * 2; k++) {
+                        const __m128d value = _mm_loadu_pd(in + j + k);
+                        acc = minimum ? _mm_min_pd(acc, value) : _mm_add_pd(acc, _mm_mul_pd(value, _mm_set1_pd(taps[k])));
+                    }
+                    _mm_storeu_pd(out + j, acc);
+                }
+#endif
+                for (; j < w; j++) {
+                    double acc = minimum ? in[j] : 0.0;
+                    for (int k = 0; k <= margin * 2; k++) {acc = minimum ? std::min(acc, in[j + k]) : acc + in[j + k] * taps[k];}
+                    out[j] = acc;
+                }
+            }
+        }
+        /** One vertical pass: like filterRows() but down columns, so output row i reads input rows i through i + 2 * margin */
+        static void filterColumns(const double* src, const int &srcPitch, double* dst, const int &dstPitch, const int &rows, const int &w, const double* taps, const int &margin, const bool &minimum) {
+            for (int i = 0; i < rows; i++) {
+                double* out = dst + (unsigned long int)i * dstPitch;
+                const double* first = src + (unsigned long int)i * srcPitch;
+                std::copy(first, first + w, out);
+                if (!minimum) {
+                    for (int j = 0; j < w; j++) {out[j] *= taps[0];}
+                }
+                for (int k = 1; k <= margin * 2; k++) {
+                    const double* in = src + (unsigned long int)(i + k) * srcPitch;
+                    int j = 0;
+#if defined(__SSE2__)
+                    const __m128d tap = _mm_set1_pd(taps[k]);
+                    for (; j + 2 <= w; j += 2) {
+                        const __m128d value = _mm_loadu_pd(in + j), acc = _mm_loadu_pd(out + j);
+                        _mm_storeu_pd(out + j, minimum ? _mm_min_pd(acc, value) : _mm_add_pd(acc, _mm_mul_pd(value, tap)));
+                    }
+#endif
+                    for (; j < w; j++) {out[j] = minimum ? std::min(out[j], in[j]) : out[j] + in[j] * taps[k];}
+                }
+            }
+        }
+
+        /** Find the stroke's tile at a tile row & column, starting it if the stroke hasn't reached it yet & marking it as reached this call */
+        StrokeTile& reachTile(const int &row, const int &col, const int &tilesW) {
+            const unsigned long int key = (unsigned long int)row * tilesW + col;
+            const std::unordered_map<unsigned long int, unsigned long int>::const_iterator found = TileIndex.find(key);
+            unsigned long int index = 0;
+            if (found == TileIndex.end()) {
+                index = TileCount++;
+                if (Tiles.size() < TileCount) {Tiles.emplace_back();}
+                StrokeTile &tile = Tiles[index];
+                tile.Row = row;
+                tile.Col = col;
+                tile.Applied.assign(BRUSH_TILE_SIZE * BRUSH_TILE_SIZE, 0.0);
+                tile.Touched = false;
+                TileIndex.emplace(key, index);
+            } else {index = found->second;}
+
+            StrokeTile &tile = Tiles[index];
+            if (!tile.Touched) {
+                tile.Touched = true;
+                tile.Reached.assign(BRUSH_TILE_SIZE * BRUSH_TILE_SIZE, 0.0);
+                Touched.push_back(index);
+            }
+            return tile;
+        }
+
+        /** Fill Filtered with the current mode's filter of a block of the grid, reading past its edges by clamping to the grid */
+        void filter(const std::vector<std::vector<double>> &grid, const int &firstRow, const int &firstCol, const int &h, const int &w, const int &radius) {
+            int margin = 1;
+            Taps.assign(3, 1.0);
+            if (Mode != BRUSH_MODE_ERODE) {
+                // The blur widens with the brush so big brushes smooth out big features
+                const double sigma = std::max(radius / 4.0, 1.0);
+                margin = std::ceil(sigma * 2.0);
+                Taps.resize(margin * 2 + 1);
+                double sum = 0.0;
+                for (int k = -margin; k <= margin; k++) {sum += Taps[k + margin] = std::exp(-k * k / (2.0 * sigma * sigma));}
+                for (unsigned long int k = 0; k < Taps.size(); k++) {Taps[k] /= sum;}
+            }
+
+            const int srcW = w + margin * 2, srcH = h + margin * 2, gridH = grid.size(), gridW = grid[0].size();
+            Source.resize((unsigned long int)srcW * srcH);
+            for (int i = 0; i < srcH; i++) {
+                const std::vector<double> &cells = grid[std::min(std::max(firstRow - margin + i, 0), gridH - 1)];
+                double* row = Source.data() + (unsigned long int)i * srcW;
+                for (int j = 0; j < srcW; j++) {row[j] = cells[std::min(std::max(firstCol - margin + j, 0), gridW - 1)];}
+            }
+            Rows.resize((unsigned long int)w * srcH);
+            Filtered.resize((unsigned long int)w * h);
+            filterRows(Source.data(), srcW, Rows.data(), w, srcH, w, Taps.data(), margin, Mode == BRUSH_MODE_ERODE);
+            filterColumns(Rows.data(), w, Filtered.data(), w, h, w, Taps.data(), margin, Mode == BRUSH_MODE_ERODE);
+        }
+
+    public:
+        /** Have every stamp & stroke report the block of cells it is about to change before changing them, e.g. so they can be captured for undo
+         * @param callback Called with a block that covers (but may be bigger than) the cells that change; empty to stop reporting    */
+        void setBeforeChange(const std::function<void(const Area&)> &callback) {BeforeChange = callback;}
+
+        /** @param shape Either BRUSH_SHAPE_DIAMOND, BRUSH_SHAPE_GAUSSIAN or BRUSH_SHAPE_COSINE    */
+        void setShape(const unsigned char &shape) {
+            if (shape == Shape) {return;}
+            Shape = shape;
+            Kernels.clear();
+        }
+        unsigned char getShape() const {return Shape;}
+        /** Choose what strokes do; stamp() always raises
+         * @param mode Either BRUSH_MODE_RAISE, BRUSH_MODE_SMOOTH, BRUSH_MODE_SHARPEN or BRUSH_MODE_ERODE    */
+        void setMode(const unsigned char &mode) {Mode = mode;}
+        unsigned char getMode() const {return Mode;}
+
+        /** Add strength to every cell under the brush, clamped to [minVal, maxVal]
+         * @param row Row of the center of the brush; nothing happens if the center is off the grid
+         * @param col Column of the center of the brush
+         * @param strength Amount added at full weight (negative to lower the terrain)
+         * @param radius Reach of the brush in cells; 0 only touches the center
+         * @returns The cells that may have changed, clipped to the grid    */
+        Area stamp(std::vector<std::vector<double>> &grid, const int &row, const int &col, const double &strength, const int &radius, const double &minVal, const double &maxVal) {
+            Area output;
+            if (radius < 0 || row < 0 || row >= (int)grid.size() || col < 0 || col >= (int)grid[row].size()) {return output;}
+
+            const Kernel &kernel = getKernel(radius);
+            const int size = radius * 2 + 1;
+            const int firstRow = std::max(row - radius, 0), lastRow = std::min(row + radius, (int)grid.size() - 1);
+            if (BeforeChange) {
+                Area box;
+                box.FirstRow = firstRow;
+                box.LastRow = lastRow;
+                box.FirstCol = std::max(col - radius, 0);
+                box.LastCol = std::min(col + radius, (int)grid[row].size() - 1);
+                BeforeChange(box);
+            }
+            for (int i = firstRow; i <= lastRow; i++) {
+                const int k = i - row + radius;
+                std::vector<double> &cells = grid[i];
+                const int first = std::max(col + kernel.SpanStart[k], 0), last = std::min(col + kernel.SpanEnd[k], (int)cells.size() - 1);
+                const double* weights = kernel.Weights.data() + (unsigned long int)k * size + radius;
+                for (int j = first; j <= last; j++) {cells[j] = std::min(std::max(cells[j] + strength * weights[j - col], minVal), maxVal);}
+                if (first <= last) {
+                    Area changed;
+                    changed.FirstRow = changed.LastRow = i;
+                    changed.FirstCol = first;
+                    changed.LastCol = last;
+                    output.merge(changed);
+                }
+            }
+            return output;
+        }
+
+        /** Start a stroke; the first applyStroke() stamps the brush here before following the samples */
+        void beginStroke(const int &row, const int &col) {
+            Stroking = true;
+            StampStart = true;
+            LastRow = row;
+            LastCol = col;
+            Samples.clear();
+            TileCount = 0;
+            TileIndex.clear();
+        }
+        /** Add a point the stroke passed through; ignored when not stroking or if the stroke hasn't moved */
+        void addSample(const int &row, const int &col) {
+            if (!Stroking) {return;}
+            const std::pair<int, int> last = Samples.empty() ? std::make_pair(LastRow, LastCol) : Samples.back();
+            if (last.first != row || last.second != col) {Samples.emplace_back(row, col);}
+        }
+        /** Stop the stroke, dropping any samples that weren't applied */
+        void endStroke() {
+            Stroking = false;
+            Samples.clear();
+        }
+        bool isStroking() const {return Stroking;}
+
+        /** Sweep the brush along every sample collected since the last call & apply it to the cells it covered
+         * The brush is centered on every cell of the line between consecutive samples, so fast strokes have no gaps. Where the stroke overlaps itself, within
+         * this call or an earlier one, a cell gets its highest weight rather than the sum, so the result doesn't depend on how the samples were split into calls.
+         * Weights are kept in BRUSH_TILE_SIZE blocks made as the brush reaches them, so the cost follows the cells swept rather than the box around them
+         * @param strength When raising, the amount added at full weight (negative to lower the terrain); otherwise how far to go towards the filtered height at full weight, from 0 to 1
+         * @param radius Reach of the brush in cells
+         * @returns The blocks of cells that may have changed, clipped to the grid; valid until the next call    */
+        const std::vector<Area>& applyStroke(std::vector<std::vector<double>> &grid, const double &strength, const int &radius, const double &minVal, const double &maxVal) {
+            Changed.clear();
+            if (!Stroking || radius < 0) {return Changed;}
+
+            // Centers in the order the stroke passed them; the point the last call ended on was already applied
+            Centers.clear();
+            if (StampStart) {Centers.emplace_back(LastRow, LastCol);}
+            for (unsigned long int i = 0; i < Samples.size(); i++) {
+                const int dRow = std::abs(Samples[i].first - LastRow), dCol = std::abs(Samples[i].second - LastCol);
+                const int stepRow = Samples[i].first > LastRow ? 1 : -1, stepCol = Samples[i].second > LastCol ? 1 : -1;
+                int error = dCol - dRow;
+                while (LastRow != Samples[i].first || LastCol != Samples[i].second) {
+                    const int error2 = error * 2;
+                    if (error2 > -dRow) {
+                        error -= dRow;
+                        LastCol += stepCol;
+                    }
+                    if (error2 < dCol) {
+                        error += dCol;
+                        LastRow += stepRow;
+                    }
+                    Centers.emplace_back(LastRow, LastCol);
+                }
+            }
+            StampStart = false;
+            Samples.clear();
+            if (Centers.empty() || grid.empty() || grid[0].empty()) {return Changed;}
+
+            // Highest weight the brush reached on every cell this call, in the tiles it reached
+            const Kernel &kernel = getKernel(radius);
+            const int size = radius * 2 + 1, gridH = grid.size(), gridW = grid[0].size();
+            const int tilesW = (gridW + BRUSH_TILE_SIZE - 1) / BRUSH_TILE_SIZE;
+            for (unsigned long int c = 0; c < Centers.size(); c++) {
+                const int row = Centers[c].first, col = Centers[c].second;
+                const int firstRow = std::max(row - radius, 0), lastRow = std::min(row + radius, gridH - 1);
+                for (int i = firstRow; i <= lastRow; i++) {
+                    const int k = i - row + radius;
+                    const int first = std::max(col + kernel.SpanStart[k], 0), last = std::min(col + kernel.SpanEnd[k], gridW - 1);
+                    const double* weights = kernel.Weights.data() + (unsigned long int)k * size + radius;
+                    for (int j = first; j <= last;) {
+                        const int tileCol = j / BRUSH_TILE_SIZE, end = std::min(last, tileCol * BRUSH_TILE_SIZE + BRUSH_TILE_SIZE - 1);
+                        double* reached = reachTile(i / BRUSH_TILE_SIZE, tileCol, tilesW).Reached.data() + (unsigned long int)(i % BRUSH_TILE_SIZE) * BRUSH_TILE_SIZE - tileCol * BRUSH_TILE_SIZE;
+                        for (; j <= end; j++) {reached[j] = std::max(reached[j], weights[j - col]);}
+                    }
+                }
+            }
+
+            // Every tile is reported & filtered before any of them change, so filters only ever see the grid as it was before this call
+            const bool filtering = Mode != BRUSH_MODE_RAISE;
+            for (unsigned long int t = 0; t < Touched.size(); t++) {
+                StrokeTile &tile = Tiles[Touched[t]];
+                Area box;
+                box.FirstRow = tile.Row * BRUSH_TILE_SIZE;
+                box.FirstCol = tile.Col * BRUSH_TILE_SIZE;
+                box.LastRow = std::min(box.FirstRow + BRUSH_TILE_SIZE, gridH) - 1;
+                box.LastCol = std::min(box.FirstCol + BRUSH_TILE_SIZE, gridW) - 1;
+                if (BeforeChange) {BeforeChange(box);}
+                if (filtering) {
+                    const int w = box.LastCol - box.FirstCol + 1, h = box.LastRow - box.FirstRow + 1;
+                    filter(grid, box.FirstRow, box.FirstCol, h, w, radius);
+                    tile.Target.assign(Filtered.begin(), Filtered.begin() + (unsigned long int)w * h);
+                }
+            }
+
+            // Only the part of a weight above what the stroke already applied to a cell is applied now
+            const double amount = filtering ? std::min(std::max(strength, 0.0), 1.0) : strength;
+            for (unsigned long int t = 0; t < Touched.size(); t++) {
+                StrokeTile &tile = Tiles[Touched[t]];
+                tile.Touched = false;
+                const int firstRow = tile.Row * BRUSH_TILE_SIZE, firstCol = tile.Col * BRUSH_TILE_SIZE;
+                const int h = std::min(BRUSH_TILE_SIZE, gridH - firstRow), w = std::min(BRUSH_TILE_SIZE, gridW - firstCol);
+                Area changed;
+                for (int i = 0; i < h; i++) {
+                    std::vector<double> &cells = grid[firstRow + i];
+                    const double* reached = tile.Reached.data() + (unsigned long int)i * BRUSH_TILE_SIZE;
+                    double* applied = tile.Applied.data() + (unsigned long int)i * BRUSH_TILE_SIZE;
+                    const double* target = filtering ? tile.Target.data() + (unsigned long int)i * w : NULL;
+                    int first = -1, last = -1;
+                    for (int j = 0; j < w; j++) {
+                        const double weight = reached[j] - applied[j];
+                        if (weight <= 0.0) {continue;}
+                        applied[j] = reached[j];
+                        double &cell = cells[firstCol + j];
+                        double change = amount;
+                        if (filtering) {change *= Mode == BRUSH_MODE_SHARPEN ? cell - target[j] : target[j] - cell;}
+                        cell = std::min(std::max(cell + change * weight, minVal), maxVal);
+                        if (first == -1) {first = j;}
+                        last = j;
+                    }
+                    if (first != -1) {
+                        Area row;
+                        row.FirstRow = row.LastRow = firstRow + i;
+                        row.FirstCol = firstCol + first;
+                        row.LastCol = firstCol + last;
+                        changed.merge(row);
+                    }
+                }
+                if (!changed.isEmpty()) {Changed.push_back(changed);}
+            }
+            Touched.clear();
+            return Changed;
+        }
+};
+
+#endif /* BRUSH */
@@ -0,0 +1,46 @@
+#ifndef COLORRAMP
+#define COLORRAMP
+
+#include <SDL2/SDL.h>
+
+#define RAMP_GREYSCALE   0    // White at the minimum to black at the maximum
+#define RAMP_HYPSOMETRIC 1    // Water, lowland greens, highland browns & rock, then snow
+#define RAMP_SLOPE       2    // Greyscale lit from the top-left by the slope between neighbouring cells
+#define RAMP_HEAT        3    // Dark blue through cyan, yellow & red; for counts & orders rather than heights
+
+/** A 256-entry table of ARGB8888 colors plus the kernels that turn whole rows of heights into pixels through it
+ * Heights are normalised to [minVal, maxVal], clamped and looked up four at a time with SSE2 when available    */
+class ColorRamp {
+    private:
+        Uint32 Table[256];
+        unsigned char Type = RAMP_GREYSCALE;
+
+        /** Normalise, clamp & look up a run of heights */
+        void lookup(const double* heights, const int &count, const double &minVal, const double &maxVal, Uint32* pixels) const;
+        void lookup(const float* heights, const int &count, const double &minVal, const double &maxVal, Uint32* pixels) const;
+        /** Darken/lighten pixels by the slope around each height; above & below are the neighbouring rows (or row itself at an edge) */
+        template <typename Height> void shade(const Height* above, const Height* row, const Height* below, const int &count, const double &minVal, const double &maxVal, Uint32* pixels) const;
+        template <typename Height> void convertRow(const Height* above, const Height* row, const Height* below, const int &count, const double &minVal, const double &maxVal, Uint32* pixels) const;
+
+    public:
+        /** @param type Either RAMP_GREYSCALE, RAMP_HYPSOMETRIC, RAMP_SLOPE or RAMP_HEAT    */
+        ColorRamp(const unsigned char &type = RAMP_GREYSCALE);
+
+        unsigned char getType() const;
+        /** @returns Whether pixels depend on the neighbouring rows as well (so edits affect the rows around them)    */
+        bool isShaded() const;
+        Uint32 getColor(const unsigned char &index) const;
+
+        /** Convert a row of heights to ARGB8888 pixels
+         * @param above The row above, or NULL; only read by shaded ramps
+         * @param row The heights to convert
+         * @param below The row below, or NULL; only read by shaded ramps
+         * @param count Number of heights in each row
+         * @param minVal Height mapped to the first color
+         * @param maxVal Height mapped to the last color
+         * @param pixels Where to write count pixels    */
+        void convert(const double* above, const double* row, const double* below, const int &count, const double &minVal, const double &maxVal, Uint32* pixels) const;
+        void convert(const float* above, const float* row, const float* below, const int &count, const double &minVal, const double &maxVal, Uint32* pixels) const;
+};
+
+#endif /* COLORRAMP */
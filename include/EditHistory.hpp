@@ -0,0 +1,247 @@
+#ifndef EDITHISTORY
+#define EDITHISTORY
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <algorithm>
+
+#include "Brush.hpp"
+
+#define HISTORY_TILE_SIZE 32    // Width & height in cells of the tiles edits are recorded in
+
+/** Undo & redo for a heightmap that only keeps the tiles an edit changed
+ * Tiles are copied the first time an edit is about to touch them; committing the edit XORs every copy with the tile's new contents and keeps only the
+ * runs of cells that changed (as raw 64-bit XORs) between counts of unchanged ones, so unchanged cells cost nothing. XOR is its own inverse, so the same
+ * delta takes a tile back & forth, and both cost O(changed tiles).
+ * The copies of the edit in progress count against the memory cap too; the oldest edits are dropped to make room, and an edit that doesn't fit on its own
+ * isn't recorded at all    */
+class EditHistory {
+    private:
+        struct TileDelta {
+            int Row = 0, Col = 0;
+            // Pairs of (zero words, literal words) counts packed into one word, each followed by its literal words
+            std::vector<std::uint64_t> Runs;
+        };
+        struct Edit {
+            std::vector<TileDelta> Tiles;
+            unsigned long int Bytes = 0;
+        };
+
+        std::deque<Edit> Undo;
+        std::vector<Edit> Redo;
+        unsigned long int Capacity;
+        unsigned long int Used = 0;
+
+        // Tiles of the edit in progress as they were before it, keyed by tile row * TilesW + tile column
+        std::unordered_map<unsigned long int, std::vector<double>> Before;
+        int TilesW = 0;
+        // Bytes held by Before, & whether the edit in progress has outgrown the cap & stopped being captured
+        unsigned long int Captured = 0;
+        bool Overflowed = false;
+
+        static std::uint64_t bits(const double &value) {
+            std::uint64_t output;
+            std::memcpy(&output, &value, sizeof(output));
+            return output;
+        }
+        static double value(const std::uint64_t &bits) {
+            double output;
+            std::memcpy(&output, &bits, sizeof(output));
+            return output;
+        }
+        static int tileW(const std::vector<std::vector<double>> &grid, const int &col) {return std::min(HISTORY_TILE_SIZE, (int)grid[0].size() - col * HISTORY_TILE_SIZE);}
+        static int tileH(const std::vector<std::vector<double>> &grid, const int &row) {return std::min(HISTORY_TILE_SIZE, (int)grid.size() - row * HISTORY_TILE_SIZE);}
+
+        static unsigned long int bytes(const Edit &edit) {
+            unsigned long int output = sizeof(Edit);
+            for (unsigned long int i = 0; i < edit.Tiles.size(); i++) {output += sizeof(TileDelta) + edit.Tiles[i].Runs.size() * sizeof(std::uint64_t);}
+            return output;
+        }
+
+        /** XOR a delta into the grid
+         * @returns The cells it covers    */
+        static Brush::Area apply(std::vector<std::vector<double>> &grid, const Edit &edit) {
+            Brush::Area output;
+            for (unsigned long int t = 0; t < edit.Tiles.size(); t++) {
+                const TileDelta &tile = edit.Tiles[t];
+                const int firstRow = tile.Row * HISTORY_TILE_SIZE, firstCol = tile.Col * HISTORY_TILE_SIZE, w = tileW(grid, tile.Col), h = tileH(grid, tile.Row);
+                int cell = 0;
+                unsigned long int i = 0;
+                while (i < tile.Runs.size()) {
+                    const std::uint64_t zeros = tile.Runs[i] >> 32, literals = tile.Runs[i] & 0xFFFFFFFF;
+                    cell += zeros;
+                    for (std::uint64_t j = 1; j <= literals; j++, cell++) {
+                        double &target = grid[firstRow + cell / w][firstCol + cell % w];
+                        target = value(bits(target) ^ tile.Runs[i + j]);
+                    }
+                    i += literals + 1;
+                }
+
+                Brush::Area covered;
+                covered.FirstRow = firstRow;
+                covered.FirstCol = firstCol;
+                covered.LastRow = firstRow + h - 1;
+                covered.LastCol = firstCol + w - 1;
+                output.merge(covered);
+            }
+            return output;
+        }
+
+        /** Drop the oldest edits until the history plus some extra bytes fits in its cap
+         * @param extra Bytes needed on top of the edits kept
+         * @param keep Number of the newest undo steps never to drop
+         * @param redoFirst Whether redo steps go before any undo step, e.g. while capturing an edit whose commit() drops them all anyway
+         * @returns Whether it fits    */
+        bool trim(const unsigned long int &extra, const unsigned long int &keep, const bool &redoFirst = false) {
+            const auto trimRedo = [&]() {
+                while (Used + extra > Capacity && !Redo.empty()) {
+                    Used -= Redo.front().Bytes;
+                    Redo.erase(Redo.begin());
+                }
+            };
+            if (redoFirst) {trimRedo();}
+            while (Used + extra > Capacity && Undo.size() > keep) {
+                Used -= Undo.front().Bytes;
+                Undo.pop_front();
+            }
+            trimRedo();
+            return Used + extra <= Capacity;
+        }
+
+        /** Forget the edit in progress */
+        void drop() {
+            Before.clear();
+            Captured = 0;
+            Overflowed = false;
+        }
+
+    public:
+        /** @param capacity Most bytes of deltas & captured tiles to keep    */
+        EditHistory(const unsigned long int &capacity = 64 << 20) : Capacity(capacity) {}
+
+        /** Remember a block of cells as it is before it changes; call before every change that should be undoable
+         * Cells already captured since the last commit() are left alone, so this can be called again & again during one edit. Older edits are dropped
+         * to make room for the copies, redo steps before undo steps since commit() drops those anyway; once the edit alone outgrows the cap, nothing more is copied & commit() will drop it
+         * @param firstRow First row about to change (clamped to the grid)
+         * @param firstCol First column about to change (clamped to the grid)
+         * @param lastRow Last row about to change, inclusive (clamped to the grid)
+         * @param lastCol Last column about to change, inclusive (clamped to the grid)    */
+        void capture(const std::vector<std::vector<double>> &grid, const int &firstRow, const int &firstCol, const int &lastRow, const int &lastCol) {
+            if (grid.empty() || grid[0].empty()) {return;}
+            const int r0 = std::max(firstRow, 0), c0 = std::max(firstCol, 0), r1 = std::min(lastRow, (int)grid.size() - 1), c1 = std::min(lastCol, (int)grid[0].size() - 1);
+            if (r0 > r1 || c0 > c1 || Overflowed) {return;}
+
+            TilesW = ((int)grid[0].size() + HISTORY_TILE_SIZE - 1) / HISTORY_TILE_SIZE;
+            for (int row = r0 / HISTORY_TILE_SIZE; row <= r1 / HISTORY_TILE_SIZE; row++) {
+                for (int col = c0 / HISTORY_TILE_SIZE; col <= c1 / HISTORY_TILE_SIZE; col++) {
+                    const unsigned long int key = (unsigned long int)row * TilesW + col;
+                    if (Before.count(key) > 0) {continue;}
+
+                    const int w = tileW(grid, col), h = tileH(grid, row);
+                    const unsigned long int size = (unsigned long int)w * h * sizeof(double);
+                    if (!trim(Captured + size, 0, true)) {
+                        drop();
+                        Overflowed = true;
+                        return;
+                    }
+                    Captured += size;
+                    std::vector<double> &tile = Before[key];
+                    tile.resize((unsigned long int)w * h);
+                    for (int i = 0; i < h; i++) {std::copy(grid[row * HISTORY_TILE_SIZE + i].begin() + col * HISTORY_TILE_SIZE, grid[row * HISTORY_TILE_SIZE + i].begin() + col * HISTORY_TILE_SIZE + w, tile.begin() + (unsigned long int)i * w);}
+                }
+            }
+        }
+        void capture(const std::vector<std::vector<double>> &grid, const Brush::Area &area) {capture(grid, area.FirstRow, area.FirstCol, area.LastRow, area.LastCol);}
+
+        /** Finish the edit in progress, turning what was captured into one undo step; clears the redo steps if anything changed
+         * An edit too big for the cap can't be undone, and neither can anything before it, so the whole history is dropped instead
+         * @returns Whether the edit was recorded; false if no cell changed or it didn't fit    */
+        bool commit(const std::vector<std::vector<double>> &grid) {
+            if (Overflowed) {
+                clear();
+                return false;
+            }
+
+            Edit edit;
+            for (std::unordered_map<unsigned long int, std::vector<double>>::const_iterator i = Before.begin(); i != Before.end(); i++) {
+                TileDelta tile;
+                tile.Row = i->first / TilesW;
+                tile.Col = i->first % TilesW;
+                const int w = tileW(grid, tile.Col), h = tileH(grid, tile.Row);
+
+                std::uint64_t zeros = 0;
+                unsigned long int header = 0;
+                for (int cell = 0; cell < w * h; cell++) {
+                    const std::uint64_t delta = bits(grid[tile.Row * HISTORY_TILE_SIZE + cell / w][tile.Col * HISTORY_TILE_SIZE + cell % w]) ^ bits(i->second[cell]);
+                    if (delta == 0) {
+                        zeros++;
+                        continue;
+                    }
+                    // A new run starts after any zeros; otherwise the literal joins the current one
+                    if (zeros > 0 || tile.Runs.empty()) {
+                        header = tile.Runs.size();
+                        tile.Runs.push_back(zeros << 32);
+                        zeros = 0;
+                    }
+                    tile.Runs[header]++;
+                    tile.Runs.push_back(delta);
+                }
+                if (!tile.Runs.empty()) {edit.Tiles.push_back(tile);}
+            }
+            drop();
+            if (edit.Tiles.empty()) {return false;}
+
+            edit.Bytes = bytes(edit);
+            for (unsigned long int i = 0; i < Redo.size(); i++) {Used -= Redo[i].Bytes;}
+            Redo.clear();
+            Used += edit.Bytes;
+            Undo.push_back(std::move(edit));
+            if (!trim(0, 1)) {
+                clear();
+                return false;
+            }
+            return true;
+        }
+
+        /** Take the grid back one edit
+         * @returns The cells that may have changed; empty if there was nothing to undo    */
+        Brush::Area undo(std::vector<std::vector<double>> &grid) {
+            if (Undo.empty()) {return Brush::Area();}
+            const Brush::Area output = apply(grid, Undo.back());
+            Redo.push_back(std::move(Undo.back()));
+            Undo.pop_back();
+            return output;
+        }
+        /** Apply the last undone edit again
+         * @returns The cells that may have changed; empty if there was nothing to redo    */
+        Brush::Area redo(std::vector<std::vector<double>> &grid) {
+            if (Redo.empty()) {return Brush::Area();}
+            const Brush::Area output = apply(grid, Redo.back());
+            Undo.push_back(std::move(Redo.back()));
+            Redo.pop_back();
+            return output;
+        }
+
+        /** Forget everything, e.g. once the grid is replaced by one of a different size */
+        void clear() {
+            Undo.clear();
+            Redo.clear();
+            drop();
+            Used = 0;
+        }
+
+        bool canUndo() const {return !Undo.empty();}
+        bool canRedo() const {return !Redo.empty();}
+        bool isCapturing() const {return !Before.empty() || Overflowed;}
+        unsigned long int getUsed() const {return Used;}
+        unsigned long int getCapacity() const {return Capacity;}
+        void setCapacity(const unsigned long int &capacity) {
+            Capacity = capacity;
+            trim(Captured, 0, isCapturing());
+        }
+};
+
+#endif /* EDITHISTORY */
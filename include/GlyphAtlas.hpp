@@ -0,0 +1,64 @@
+#ifndef GLYPHATLAS
+#define GLYPHATLAS
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/** Every glyph of one font rasterised (in white) once into a shared texture, plus a cache of laid out strings
+ * Strings are drawn as one textured quad per glyph, tinted through the vertex color    */
+class GlyphAtlas {
+    public:
+        struct Glyph {
+            SDL_Rect Frame = {0, 0, 0, 0};
+            int Advance = 0;
+        };
+        struct Layout {
+            // Quads relative to the top-left corner of the text, in white
+            std::vector<SDL_Vertex> Vertices;
+            std::vector<int> Indices;
+            int W = 0;
+            int H = 0;
+        };
+
+    private:
+        SDL_Renderer* Renderer = NULL;
+        TTF_Font* Font = NULL;
+        SDL_Surface* Pixels = NULL;
+        SDL_Texture* Source = NULL;
+        // Textures replaced by grow() that queued draws may still point at
+        std::vector<SDL_Texture*> Retired;
+        int PenX = 0;
+        int PenY = 0;
+        int RowH = 0;
+
+        std::unordered_map<Uint16, Glyph> Glyphs;
+        std::unordered_map<std::u16string, Layout> Layouts;
+
+        /** Double the atlas height, keeping every glyph where it is; cached layouts are dropped since their texture coordinates change */
+        bool grow();
+
+    public:
+        GlyphAtlas(SDL_Renderer* renderer, TTF_Font* font, const int &size = 512);
+        ~GlyphAtlas();
+
+        GlyphAtlas(const GlyphAtlas&) = delete;
+        GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+        SDL_Texture* getTexture() const;
+        /** Destroy the textures left behind by the atlas growing; only call once nothing queued refers to them */
+        void releaseRetired();
+
+        /** Get a glyph, rasterising it into the atlas the first time it is used
+         * @returns NULL if the font has no such glyph or the atlas could not hold it    */
+        const Glyph* getGlyph(const Uint16 &ch);
+
+        /** Lay out a string, or fetch its cached layout
+         * @param text Null-terminated string; '\n' starts a new line
+         * @param wrapWidth Width in pixels to word wrap at; 0 disables wrapping    */
+        const Layout& layout(const char16_t* text, const Uint32 &wrapWidth = 0);
+};
+
+#endif /* GLYPHATLAS */
@@ -0,0 +1,202 @@
+#ifndef HEIGHTPYRAMID
+#define HEIGHTPYRAMID
+
+#include <vector>
+#include <algorithm>
+
+#define PYRAMID_MEAN 0    // Average of every cell covered
+#define PYRAMID_MIN  1    // Lowest cell covered
+#define PYRAMID_MAX  2    // Highest cell covered
+
+#define PYRAMID_CHANGE_LOG 64    // Number of recent changes getChanged() can look back over
+
+/** Min/max/mean mipmaps of a heightmap so it can be drawn at any zoom level without touching every cell
+ * Depth 0 is the heightmap itself; every further depth halves the resolution, so one of its cells covers 2^depth x 2^depth cells of the heightmap.
+ * Edits only rebuild the cells above the area that changed    */
+class HeightPyramid {
+    public:
+        struct Level {
+            int W = 0, H = 0;
+            // Width & height of the area of the heightmap one cell covers
+            int Span = 1;
+            std::vector<float> Min, Max, Mean;
+        };
+
+    private:
+        int W = 0, H = 0;
+        // Levels[i] is depth i + 1
+        std::vector<Level> Levels;
+        unsigned long int Version = 0;
+        // Block of the heightmap each of the last few versions changed (inclusive), indexed by version
+        struct Change {
+            unsigned long int Version = 0;
+            int FirstRow = 0, FirstCol = 0, LastRow = -1, LastCol = -1;
+        };
+        Change Changes[PYRAMID_CHANGE_LOG];
+
+        /** Number of heightmap rows/columns covered by cell i of a level with the given span */
+        static int covered(const int &i, const int &span, const int &size) {return std::min(span, size - i * span);}
+
+        /** Recompute a block of cells (in the level's own coordinates, inclusive) from the depth below it */
+        void reduce(const std::vector<std::vector<double>> &grid, const unsigned long int &index, const int &firstRow, const int &firstCol, const int &lastRow, const int &lastCol) {
+            Level &level = Levels[index];
+            for (int i = firstRow; i <= lastRow; i++) {
+                for (int j = firstCol; j <= lastCol; j++) {
+                    float low = 0.0f, high = 0.0f;
+                    double sum = 0.0, weight = 0.0;
+                    bool first = true;
+                    for (int ci = i * 2; ci < i * 2 + 2; ci++) {
+                        for (int cj = j * 2; cj < j * 2 + 2; cj++) {
+                            float childMin, childMax, childMean;
+                            double childWeight;
+                            if (index == 0) {
+                                if (ci >= H || cj >= W) {continue;}
+                                childMin = childMax = childMean = grid[ci][cj];
+                                childWeight = 1.0;
+                            } else {
+                                const Level &child = Levels[index - 1];
+                                if (ci >= child.H || cj >= child.W) {continue;}
+                                const unsigned long int c = (unsigned long int)ci * child.W + cj;
+                                childMin = child.Min[c];
+                                childMax = child.Max[c];
+                                childMean = child.Mean[c];
+                                childWeight = (double)covered(ci, child.Span, H) * covered(cj, child.Span, W);
+                            }
+                            low = first ? childMin : std::min(low, childMin);
+                            high = first ? childMax : std::max(high, childMax);
+                            sum += childMean * childWeight;
+                            weight += childWeight;
+                            first = false;
+                        }
+                    }
+                    const unsigned long int c = (unsigned long int)i * level.W + j;
+                    level.Min[c] = low;
+                    level.Max[c] = high;
+                    level.Mean[c] = weight > 0.0 ? sum / weight : 0.0;
+                }
+            }
+        }
+
+    public:
+        HeightPyramid() {}
+        HeightPyramid(const std::vector<std::vector<double>> &grid) {build(grid);}
+
+        /** Rebuild every depth from scratch; every row of the grid must be the same length */
+        void build(const std::vector<std::vector<double>> &grid) {
+            H = grid.size();
+            W = grid.empty() ? 0 : grid[0].size();
+            Levels.clear();
+
+            int w = W, h = H, span = 1;
+            while (w > 1 || h > 1) {
+                w = (w + 1) / 2;
+                h = (h + 1) / 2;
+                span *= 2;
+                Levels.emplace_back();
+                Levels.back().W = w;
+                Levels.back().H = h;
+                Levels.back().Span = span;
+                Levels.back().Min.resize((unsigned long int)w * h);
+                Levels.back().Max.resize((unsigned long int)w * h);
+                Levels.back().Mean.resize((unsigned long int)w * h);
+            }
+            update(grid, 0, 0, H - 1, W - 1);
+        }
+
+        /** Bring the depths above a changed block of the heightmap up to date
+         * @param firstRow First changed row (clamped to the grid)
+         * @param firstCol First changed column (clamped to the grid)
+         * @param lastRow Last changed row, inclusive (clamped to the grid)
+         * @param lastCol Last changed column, inclusive (clamped to the grid)    */
+        void update(const std::vector<std::vector<double>> &grid, const int &firstRow, const int &firstCol, const int &lastRow, const int &lastCol) {
+            if ((int)grid.size() != H || (H > 0 && (int)grid[0].size() != W)) {
+                build(grid);
+                return;
+            }
+            int r0 = std::max(firstRow, 0), c0 = std::max(firstCol, 0), r1 = std::min(lastRow, H - 1), c1 = std::min(lastCol, W - 1);
+            if (r0 > r1 || c0 > c1) {return;}
+            Version++;
+            Changes[Version % PYRAMID_CHANGE_LOG] = {Version, r0, c0, r1, c1};
+
+            for (unsigned long int i = 0; i < Levels.size(); i++) {
+                r0 /= 2;
+                c0 /= 2;
+                r1 /= 2;
+                c1 /= 2;
+                reduce(grid, i, r0, c0, r1, c1);
+            }
+        }
+
+        int getW() const {return W;}
+        int getH() const {return H;}
+        /** @returns The deepest depth there is (the one with a single cell)    */
+        int getMaxDepth() const {return Levels.size();}
+        /** @returns A counter that changes whenever the pyramid does    */
+        unsigned long int getVersion() const {return Version;}
+        /** Get the block of the heightmap changed since an earlier version, so whatever was drawn from it only has to redraw that much
+         * A rebuild counts as changing the whole heightmap
+         * @param since Version the caller last saw
+         * @param firstRow Set to the first changed row; the block is empty (firstRow > lastRow) if nothing changed
+         * @param lastRow Set to the last changed row, inclusive
+         * @returns Whether the block is known; false when since is more than PYRAMID_CHANGE_LOG versions old    */
+        bool getChanged(const unsigned long int &since, int &firstRow, int &firstCol, int &lastRow, int &lastCol) const {
+            firstRow = firstCol = 0;
+            lastRow = lastCol = -1;
+            if (since > Version || Version - since > PYRAMID_CHANGE_LOG) {return false;}
+            for (unsigned long int v = since + 1; v <= Version; v++) {
+                const Change &change = Changes[v % PYRAMID_CHANGE_LOG];
+                if (change.Version != v) {return false;}
+                if (lastRow < firstRow) {
+                    firstRow = change.FirstRow;
+                    firstCol = change.FirstCol;
+                    lastRow = change.LastRow;
+                    lastCol = change.LastCol;
+                } else {
+                    firstRow = std::min(firstRow, change.FirstRow);
+                    firstCol = std::min(firstCol, change.FirstCol);
+                    lastRow = std::max(lastRow, change.LastRow);
+                    lastCol = std::max(lastCol, change.LastCol);
+                }
+            }
+            return true;
+        }
+
+        /** @param depth 1 through getMaxDepth()    */
+        const Level& getLevel(const int &depth) const {return Levels[depth - 1];}
+        int getW(const int &depth) const {return depth <= 0 ? W : Levels[depth - 1].W;}
+        int getH(const int &depth) const {return depth <= 0 ? H : Levels[depth - 1].H;}
+
+        /** Get every cell of a depth past 0 as a row-major plane
+         * @param depth 1 through getMaxDepth()
+         * @param mode Either PYRAMID_MEAN, PYRAMID_MIN or PYRAMID_MAX    */
+        const std::vector<float>& getValues(const int &depth, const unsigned char &mode = PYRAMID_MEAN) const {
+            const Level &level = Levels[depth - 1];
+            return mode == PYRAMID_MIN ? level.Min : mode == PYRAMID_MAX ? level.Max : level.Mean;
+        }
+
+        /** Pick the coarsest depth whose cells are no bigger than a screen pixel
+         * @param cellsPerPixel Heightmap cells covered by one pixel along each axis    */
+        int pickDepth(const double &cellsPerPixel) const {
+            int depth = 0;
+            while (depth < (int)Levels.size() && Levels[depth].Span <= cellsPerPixel) {depth++;}
+            return depth;
+        }
+
+        /** Get one cell of a depth
+         * @param grid The heightmap the pyramid was built from (read at depth 0)
+         * @param mode Either PYRAMID_MEAN, PYRAMID_MIN or PYRAMID_MAX    */
+        double sample(const std::vector<std::vector<double>> &grid, const int &depth, const int &row, const int &col, const unsigned char &mode = PYRAMID_MEAN) const {
+            if (depth <= 0) {return grid[row][col];}
+            const Level &level = Levels[depth - 1];
+            const unsigned long int c = (unsigned long int)row * level.W + col;
+            switch (mode) {
+                case PYRAMID_MIN:
+                    return level.Min[c];
+                case PYRAMID_MAX:
+                    return level.Max[c];
+            }
+            return level.Mean[c];
+        }
+};
+
+#endif /* HEIGHTPYRAMID */
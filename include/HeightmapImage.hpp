@@ -0,0 +1,28 @@
+#ifndef HEIGHTMAPIMAGE
+#define HEIGHTMAPIMAGE
+
+#include <string>
+#include <vector>
+
+/** Greyscale heightmap images, as delivered by terrain tools
+ * PNGs (any bit depth; colour is converted to grey & alpha dropped) go through libpng, binary PGMs (P5) are read directly; both are streamed a row at a
+ * time through a single row buffer. Black is the lowest height & white the highest    */
+
+/** @returns Whether a path ends in .png or .pgm (in any case)    */
+bool isHeightmapImage(const std::string &path);
+
+/** Read a PNG or binary PGM into a grid, replacing its contents; the format is told by the file's signature
+ * The image is decoded into a grid of its own that only replaces this one once every row has been read, so a failed import leaves the grid untouched
+ * (at the cost of both grids being in memory until then)
+ * @param minVal Height black maps to
+ * @param maxVal Height white maps to
+ * @returns Whether the whole image was read    */
+bool importHeightmap(const std::string &path, std::vector<std::vector<double>> &grid, const double &minVal, const double &maxVal);
+
+/** Write a grid as a 16-bit greyscale image; paths ending in .pgm are written as binary PGMs, everything else as PNGs
+ * @param minVal Height written as black; lower heights are clamped to it
+ * @param maxVal Height written as white; higher heights are clamped to it
+ * @returns Whether the image was written    */
+bool exportHeightmap(const std::string &path, const std::vector<std::vector<double>> &grid, const double &minVal, const double &maxVal);
+
+#endif /* HEIGHTMAPIMAGE */
@@ -0,0 +1,89 @@
+#ifndef MAPFILE
+#define MAPFILE
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define MAPFILE_VERSION 1       // Format version written; files of any other version are refused
+#define MAPFILE_TILE_SIZE 64    // Default width & height in cells of the tiles the planes are split into
+#define MAPFILE_ALIGN 4096      // Byte alignment of the first tile, so the planes start on a page boundary
+
+#define MAPFILE_FLOAT32 0    // Heights stored as they are in 32-bit floats
+#define MAPFILE_UINT16  1    // Heights stored as 16-bit fractions of the way from the header's minimum to its maximum
+
+#define MAPFILE_CHECKSUMS 0x01    // A CRC-32 of every tile is stored between the header & the tiles
+
+/** A heightmap saved as a fixed header followed by equally sized raw tiles, opened by memory-mapping the file instead of parsing it
+ * Tiles run across then down the map and edge tiles are padded to full size, so every tile sits at a fixed offset & cells can be read straight
+ * out of the mapping. Everything is little-endian; big-endian hosts swap values as they read & write them    */
+class MapFile {
+    public:
+        struct Header {
+            char Magic[8];
+            std::uint32_t Version;
+            std::uint32_t W, H;
+            std::uint32_t TileSize;
+            // Either MAPFILE_FLOAT32 or MAPFILE_UINT16
+            std::uint32_t Type;
+            std::uint32_t Flags;
+            // Range of the heights; MAPFILE_UINT16 files are stored relative to it
+            double MinVal, MaxVal;
+            // Byte offsets of the checksums (0 if there are none) & of the first tile
+            std::uint64_t ChecksumOffset;
+            std::uint64_t DataOffset;
+        };
+
+    private:
+        const unsigned char* Data = NULL;
+        std::uint64_t Size = 0;
+        Header Info;
+#ifdef _WIN32
+        void* File = NULL;
+        void* Mapping = NULL;
+#endif
+
+        std::uint64_t getTileBytes() const;
+
+    public:
+        MapFile() {}
+        ~MapFile();
+
+        MapFile(const MapFile&) = delete;
+        MapFile& operator=(const MapFile&) = delete;
+
+        /** Map a file into memory read-only & check its header, closing whatever was open before
+         * @returns Whether the file is a map this version can read    */
+        bool open(const std::string &path);
+        void close();
+        bool isOpen() const;
+
+        const Header& getHeader() const;
+        int getW() const;
+        int getH() const;
+        int getTilesW() const;
+        int getTilesH() const;
+        /** @returns The raw cells of a tile inside the mapping, TileSize x TileSize little-endian values of the header's type    */
+        const void* getTile(const int &tileRow, const int &tileCol) const;
+        /** @returns The height of one cell, read from the mapping    */
+        double get(const int &row, const int &col) const;
+
+        /** Check every tile against its stored checksum
+         * @returns Whether every tile matches; true for files without checksums    */
+        bool verify() const;
+        /** Decode the whole map into a grid, replacing its contents; rows are decoded across several threads
+         * The mapping is read-only and may hold 16-bit or byte-swapped values, while the editor's grid is rows of doubles that brushes, the history, the pyramid
+         * & the pathfinder all work on, so the grid gets its own copy; use get() or getTile() to read cells straight out of the mapping instead
+         * @param threads Number of worker threads; 0 uses every available core    */
+        void read(std::vector<std::vector<double>> &grid, const unsigned int &threads = 0) const;
+
+        /** Write a grid to a map file, through a temporary file next to it that replaces the old map only once it is complete
+         * @param type Either MAPFILE_FLOAT32 or MAPFILE_UINT16
+         * @param minVal Lowest height of the map; MAPFILE_UINT16 clamps to this
+         * @param maxVal Highest height of the map; MAPFILE_UINT16 clamps to this
+         * @param checksums Whether to store a CRC-32 of every tile
+         * @returns Whether the file was written    */
+        static bool save(const std::string &path, const std::vector<std::vector<double>> &grid, const unsigned char &type, const double &minVal, const double &maxVal, const bool &checksums = true, const int &tileSize = MAPFILE_TILE_SIZE);
+};
+
+#endif /* MAPFILE */
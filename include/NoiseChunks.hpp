@@ -0,0 +1,283 @@
+#ifndef NOISECHUNKS
+#define NOISECHUNKS
+
+#include <vector>
+#include <algorithm>
+#include <list>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "Perlin.hpp"
+
+#define NOISE_CHUNK_SIZE 64    // Default width & height in cells of a chunk
+
+/** Streams fixed-size tiles of octave noise at any world coordinate
+ * Tiles are generated on demand, kept in a bounded LRU cache and their neighbours are prefetched on a background thread.
+ * Prefetched tiles sit in a list of their own until they are asked for, so prefetching only ever pushes out other prefetched tiles, never ones in use    */
+class NoiseChunks {
+    public:
+        struct Chunk {
+            long long Row = 0, Col = 0;
+            std::vector<double> Values;
+        };
+
+    private:
+        struct Key {
+            long long Row, Col;
+            bool operator==(const Key &key) const {return Row == key.Row && Col == key.Col;}
+        };
+        struct KeyHash {
+            std::size_t operator()(const Key &key) const {return std::hash<unsigned long long>()((unsigned long long)key.Row * 0x9E3779B97F4A7C15ull ^ (unsigned long long)key.Col);}
+        };
+        struct Entry {
+            std::shared_ptr<const Chunk> Data;
+            // Whether the chunk is still only prefetched, & where it is in that list
+            bool Prefetched = false;
+            std::list<Key>::iterator Position;
+        };
+
+        const int ChunkSize;
+        const unsigned long int Capacity;
+        const int Octaves;
+        const double Bias;
+        const double Scale;
+        const NoiseSampler Sampler;
+
+        std::unordered_map<Key, Entry, KeyHash> Cache;
+        // Most recently used first; chunks that have been asked for & chunks only prefetched so far
+        std::list<Key> Demanded, Prefetched;
+        std::mutex CacheLock;
+
+        std::deque<Key> Pending;
+        std::unordered_set<Key, KeyHash> Queued;
+        std::mutex QueueLock;
+        std::condition_variable QueueSignal;
+        bool Stopping = false;
+        std::thread Prefetcher;
+
+        static long long floorDiv(const long long &a, const long long &b) {return a / b - (a % b != 0 && (a < 0) != (b < 0));}
+
+        void generateRow(Chunk &chunk, const int &i) const {
+            const long long row = chunk.Row * ChunkSize + i, col0 = chunk.Col * ChunkSize;
+            double* values = chunk.Values.data() + (unsigned long int)i * ChunkSize;
+            for (int j = 0; j < ChunkSize; j++) {values[j] = Sampler(row, col0 + j, Octaves, Bias, Scale);}
+        }
+        std::shared_ptr<Chunk> allocate(const Key &key) const {
+            std::shared_ptr<Chunk> output = std::make_shared<Chunk>();
+            output->Row = key.Row;
+            output->Col = key.Col;
+            output->Values.resize((unsigned long int)ChunkSize * ChunkSize);
+            return output;
+        }
+
+        /** Look up a chunk and mark it as most recently used, moving it out of the prefetched list if it was there; returns NULL on a miss */
+        std::shared_ptr<const Chunk> lookup(const Key &key) {
+            std::lock_guard<std::mutex> lock(CacheLock);
+            std::unordered_map<Key, Entry, KeyHash>::iterator found = Cache.find(key);
+            if (found == Cache.end()) {return NULL;}
+            Entry &entry = found->second;
+            Demanded.splice(Demanded.begin(), entry.Prefetched ? Prefetched : Demanded, entry.Position);
+            entry.Prefetched = false;
+            return entry.Data;
+        }
+
+        /** Insert a freshly generated chunk; returns whichever copy ends up being used
+         * Demanded chunks evict prefetched ones first & then the least recently used; prefetched chunks only evict other prefetched ones and are dropped if there are none    */
+        std::shared_ptr<const Chunk> insert(const Key &key, const std::shared_ptr<const Chunk> &chunk, const bool &prefetched) {
+            std::lock_guard<std::mutex> lock(CacheLock);
+            std::unordered_map<Key, Entry, KeyHash>::iterator found = Cache.find(key);
+            if (found != Cache.end()) {
+                Entry &entry = found->second;
+                if (!prefetched) {
+                    Demanded.splice(Demanded.begin(), entry.Prefetched ? Prefetched : Demanded, entry.Position);
+                    entry.Prefetched = false;
+                }
+                return entry.Data;
+            }
+
+            while (Cache.size() >= Capacity) {
+                std::list<Key> &victims = !Prefetched.empty() ? Prefetched : Demanded;
+                if (prefetched && &victims == &Demanded) {return chunk;}
+                Cache.erase(victims.back());
+                victims.pop_back();
+            }
+            std::list<Key> &order = prefetched ? Prefetched : Demanded;
+            order.push_front(key);
+            Entry &entry = Cache[key];
+            entry.Data = chunk;
+            entry.Prefetched = prefetched;
+            entry.Position = order.begin();
+            return chunk;
+        }
+
+        bool isCached(const Key &key) {
+            std::lock_guard<std::mutex> lock(CacheLock);
+            return Cache.count(key) > 0;
+        }
+
+        void prefetchLoop() {
+            while (true) {
+                Key key;
+                {
+                    std::unique_lock<std::mutex> lock(QueueLock);
+                    QueueSignal.wait(lock, [this]() {return Stopping || !Pending.empty();});
+                    if (Stopping) {return;}
+                    key = Pending.front();
+                    Pending.pop_front();
+                }
+
+                if (!isCached(key)) {
+                    const std::shared_ptr<Chunk> chunk = allocate(key);
+                    for (int i = 0; i < ChunkSize; i++) {generateRow(*chunk, i);}
+                    insert(key, chunk, true);
+                }
+
+                std::lock_guard<std::mutex> lock(QueueLock);
+                Queued.erase(key);
+            }
+        }
+
+        /** Queue the uncached chunks of a block (inclusive) for the background thread, keeping at most Capacity waiting */
+        void queue(const long long &firstRow, const long long &firstCol, const long long &lastRow, const long long &lastCol) {
+            std::vector<Key> keys;
+            for (long long i = firstRow; i <= lastRow; i++) {
+                for (long long j = firstCol; j <= lastCol; j++) {
+                    const Key key = {i, j};
+                    if (!isCached(key)) {keys.push_back(key);}
+                }
+            }
+            if (keys.empty()) {return;}
+
+            bool queued = false;
+            {
+                std::lock_guard<std::mutex> lock(QueueLock);
+                for (unsigned long int i = 0; i < keys.size(); i++) {
+                    if (Queued.count(keys[i]) > 0) {continue;}
+                    Queued.insert(keys[i]);
+                    Pending.push_back(keys[i]);
+                    queued = true;
+                }
+                while (Pending.size() > Capacity) {
+                    Queued.erase(Pending.front());
+                    Pending.pop_front();
+                }
+            }
+            if (queued) {QueueSignal.notify_one();}
+        }
+
+    public:
+        /** @param chunkSize Width and height of every chunk in cells
+         * @param capacity Maximum number of chunks kept in memory
+         * @param o Number of octaves
+         * @param bias Frequency multiplier (and amplitude divisor) between octaves
+         * @param scale Size of the base octave in cells
+         * @param interp Interpolation curve; either PERLIN_INTERP_LINEAR, PERLIN_INTERP_CUBIC or PERLIN_INTERP_QUINTIC
+         * @param kernel Noise kernel; either NOISE_KERNEL_PERLIN or NOISE_KERNEL_SIMPLEX    */
+        NoiseChunks(const int &chunkSize = NOISE_CHUNK_SIZE, const unsigned long int &capacity = 256, const int &o = 8, const double &bias = 2.0, const double &scale = 350.0, const unsigned char &interp = PERLIN_INTERP_QUINTIC, const unsigned char &kernel = NOISE_KERNEL_PERLIN) : ChunkSize(chunkSize > 0 ? chunkSize : 1), Capacity(capacity > 0 ? capacity : 1), Octaves(o), Bias(bias), Scale(scale), Sampler(getNoiseSampler(o, bias, interp, kernel)) {
+            Prefetcher = std::thread(&NoiseChunks::prefetchLoop, this);
+        }
+        ~NoiseChunks() {
+            {
+                std::lock_guard<std::mutex> lock(QueueLock);
+                Stopping = true;
+            }
+            QueueSignal.notify_all();
+            Prefetcher.join();
+        }
+
+        NoiseChunks(const NoiseChunks&) = delete;
+        NoiseChunks& operator=(const NoiseChunks&) = delete;
+
+        int getChunkSize() const {return ChunkSize;}
+        unsigned long int getCapacity() const {return Capacity;}
+        int getOctaves() const {return Octaves;}
+        double getBias() const {return Bias;}
+        double getScale() const {return Scale;}
+        unsigned long int getCachedCount() {
+            std::lock_guard<std::mutex> lock(CacheLock);
+            return Cache.size();
+        }
+
+        /** Get a chunk by chunk coordinates, generating it on the calling thread on a cache miss
+         * @param prefetchRadius Radius (in chunks) of the neighbourhood queued up for the background thread; 0 disables prefetching    */
+        std::shared_ptr<const Chunk> getChunk(const long long &chunkRow, const long long &chunkCol, const int &prefetchRadius = 1) {
+            const Key key = {chunkRow, chunkCol};
+            std::shared_ptr<const Chunk> output = lookup(key);
+            if (!output) {
+                const std::shared_ptr<Chunk> chunk = allocate(key);
+                for (int i = 0; i < ChunkSize; i++) {generateRow(*chunk, i);}
+                output = insert(key, chunk, false);
+            }
+            if (prefetchRadius > 0) {prefetch(chunkRow, chunkCol, prefetchRadius);}
+            return output;
+        }
+
+        /** Queue the chunks surrounding a chunk for generation on the background thread */
+        void prefetch(const long long &chunkRow, const long long &chunkCol, const int &radius = 1) {queue(chunkRow - radius, chunkCol - radius, chunkRow + radius, chunkCol + radius);}
+        /** Queue every chunk a window of the world touches for generation on the background thread, e.g. the window a view is about to move to
+         * @param row World row of the window's top-left cell
+         * @param col World column of the window's top-left cell
+         * @param w Width of the window in cells
+         * @param h Height of the window in cells    */
+        void prefetchRegion(const long long &row, const long long &col, const int &w, const int &h) {
+            if (w <= 0 || h <= 0) {return;}
+            queue(floorDiv(row, ChunkSize), floorDiv(col, ChunkSize), floorDiv(row + h - 1, ChunkSize), floorDiv(col + w - 1, ChunkSize));
+        }
+
+        /** Get the noise value of a single cell at any world coordinate */
+        double at(const long long &row, const long long &col) {
+            const long long chunkRow = floorDiv(row, ChunkSize), chunkCol = floorDiv(col, ChunkSize);
+            const std::shared_ptr<const Chunk> chunk = getChunk(chunkRow, chunkCol, 0);
+            return chunk->Values[(unsigned long int)(row - chunkRow * ChunkSize) * ChunkSize + (unsigned long int)(col - chunkCol * ChunkSize)];
+        }
+
+        /** Fill a grid with a window of the world, mapped onto a height range, & queue the ring of chunks around it for the background thread
+         * Chunks that aren't cached yet are generated across several threads first; the grid keeps its size
+         * @param row World row of the grid's top-left cell
+         * @param col World column of the grid's top-left cell
+         * @param minVal Height a noise value of 0 maps to
+         * @param maxVal Height a noise value of 1 maps to    */
+        void readRegion(const long long &row, const long long &col, std::vector<std::vector<double>> &grid, const double &minVal = 0.0, const double &maxVal = 1.0) {
+            if (grid.empty() || grid[0].empty()) {return;}
+            const int w = grid[0].size(), h = grid.size();
+            const long long firstRow = floorDiv(row, ChunkSize), lastRow = floorDiv(row + h - 1, ChunkSize);
+            const long long firstCol = floorDiv(col, ChunkSize), lastCol = floorDiv(col + w - 1, ChunkSize);
+            const long long chunksW = lastCol - firstCol + 1;
+
+            // Cached chunks are taken as they are; the rest are generated a row at a time across every core & then cached
+            std::vector<std::shared_ptr<const Chunk>> chunks((unsigned long int)chunksW * (lastRow - firstRow + 1));
+            std::vector<std::shared_ptr<Chunk>> missing;
+            std::vector<unsigned long int> slots;
+            for (unsigned long int i = 0; i < chunks.size(); i++) {
+                const Key key = {firstRow + (long long)i / chunksW, firstCol + (long long)i % chunksW};
+                if (!(chunks[i] = lookup(key))) {
+                    missing.push_back(allocate(key));
+                    slots.push_back(i);
+                }
+            }
+            forEachRowBand(missing.size() * ChunkSize, 0, [&](const int &i) {generateRow(*missing[i / ChunkSize], i % ChunkSize);});
+            for (unsigned long int i = 0; i < missing.size(); i++) {chunks[slots[i]] = insert({missing[i]->Row, missing[i]->Col}, missing[i], false);}
+
+            const double range = maxVal - minVal;
+            for (int i = 0; i < h; i++) {
+                const long long r = row + i, chunkRow = floorDiv(r, ChunkSize);
+                double* cells = grid[i].data();
+                for (long long cc = firstCol; cc <= lastCol; cc++) {
+                    const Chunk &chunk = *chunks[(unsigned long int)(chunkRow - firstRow) * chunksW + (cc - firstCol)];
+                    const long long c0 = std::max(col, cc * ChunkSize), c1 = std::min(col + w, (cc + 1) * ChunkSize);
+                    const double* src = chunk.Values.data() + (unsigned long int)(r - chunkRow * ChunkSize) * ChunkSize + (unsigned long int)(c0 - cc * ChunkSize);
+                    for (long long c = c0; c < c1; c++) {cells[c - col] = minVal + src[c - c0] * range;}
+                }
+            }
+
+            queue(firstRow - 1, firstCol - 1, lastRow + 1, lastCol + 1);
+        }
+};
+
+#endif /* NOISECHUNKS */
@@ -4,23 +4,40 @@
 #include <cmath>
 #include <vector>
 #include <utility>
+#include <algorithm>
 
-double interpolate(double a0, double a1, double w) {
+#include "RowBands.hpp"
+
+#define PERLIN_INTERP_LINEAR  0
+#define PERLIN_INTERP_CUBIC   1
+#define PERLIN_INTERP_QUINTIC 2
+
+/** Interpolation curves for the Perlin kernel, used as compile-time parameters of PerlinKernel */
+struct PerlinLinear {
+    static double interpolate(const double &a0, const double &a1, const double &w) {return (a1 - a0) * w + a0;}
+    static double slope(const double &) {return 1.0;}
+};
+struct PerlinCubic {
+    // Smoother than linear
+    static double interpolate(const double &a0, const double &a1, const double &w) {return (a1 - a0) * (3.0 - w * 2.0) * w * w + a0;}
+    static double slope(const double &w) {return 6.0 * w * (1.0 - w);}
+};
+struct PerlinQuintic {
+    // Smoothest interpolation (2nd derivative is zero on boundaries)
+    static double interpolate(const double &a0, const double &a1, const double &w) {return (a1 - a0) * ((w * (w * 6.0 - 15.0) + 10.0) * w * w * w) + a0;}
+    static double slope(const double &w) {return 30.0 * w * w * (w - 1.0) * (w - 1.0);}
+};
+
+inline double interpolate(double a0, double a1, double w) {
     // Add to clamp values
     // if (0.0 > w) return a0;
     // if (1.0 < w) return a1;
 
-    // Linear interpolation
-    // return (a1 - a0) * w + a0;
-    
-    // Cubic interpolation (smoother than linear)
-    // return (a1 - a0) * (3.0 - w * 2.0) * w * w + a0;
-
-    // Smoothest interpolation (2nd derivative is zero on boundaries)
-    return (a1 - a0) * ((w * (w * 6.0 - 15.0) + 10.0) * w * w * w) + a0;
+    // See PerlinLinear and PerlinCubic for the other curves
+    return PerlinQuintic::interpolate(a0, a1, w);
 }
 
-std::pair<double, double> randomGradient(int ix, int iy) {
+inline unsigned latticeHash(int ix, int iy) {
     const unsigned w = 8 * sizeof(unsigned), s = w / 2;
     unsigned a = ix, b = iy;
 
@@ -31,48 +48,419 @@ std::pair<double, double> randomGradient(int ix, int iy) {
     
     a ^= b << s | b >> (w - s);
     a *= 2048419325;
-    
-    double random = a * (M_PI / ~(~0u >> 1));
+
+    return a;
+}
+
+inline std::pair<double, double> randomGradient(int ix, int iy) {
+    double random = latticeHash(ix, iy) * (M_PI / ~(~0u >> 1));
     return {std::cos(random), std::sin(random)};
 }
 
-double dotGridGradient(int ix, int iy, double x, double y) {
+inline double dotGridGradient(int ix, int iy, double x, double y) {
     std::pair<double, double> gradient = randomGradient(ix, iy);
     return ((x - (double)ix) * gradient.first + (y - (double)iy) * gradient.second);
 }
 
-double perlin(double x, double y) {
-    int x0 = (int)x, x1 = x0 + 1, y0 = (int)y, y1 = y0 + 1;
-    double sx = x - (double)x0;
+#define NOISE_KERNEL_PERLIN  0
+#define NOISE_KERNEL_SIMPLEX 1
+
+/** Classic Perlin kernel; samples the four lattice corners around the point */
+template <typename Curve> struct PerlinKernel {
+    static double sample(const double &x, const double &y) {
+        int x0 = (int)std::floor(x), x1 = x0 + 1, y0 = (int)std::floor(y), y1 = y0 + 1;
+        double sx = x - (double)x0;
+
+        return Curve::interpolate(Curve::interpolate(dotGridGradient(x0, y0, x, y), dotGridGradient(x1, y0, x, y), sx), Curve::interpolate(dotGridGradient(x0, y1, x, y), dotGridGradient(x1, y1, x, y), sx), y - (double)y0);
+    }
+
+    /** Sample the kernel along with its analytic partial derivatives; the value matches sample() exactly */
+    static double sample(const double &x, const double &y, double &dx, double &dy) {
+        const int x0 = (int)std::floor(x), x1 = x0 + 1, y0 = (int)std::floor(y), y1 = y0 + 1;
+        const double sx = x - (double)x0, sy = y - (double)y0;
+
+        const std::pair<double, double> g00 = randomGradient(x0, y0), g10 = randomGradient(x1, y0), g01 = randomGradient(x0, y1), g11 = randomGradient(x1, y1);
+        // Same corner terms as dotGridGradient(), so the value below is bit-identical to sample()
+        const double n00 = (x - (double)x0) * g00.first + (y - (double)y0) * g00.second;
+        const double n10 = (x - (double)x1) * g10.first + (y - (double)y0) * g10.second;
+        const double n01 = (x - (double)x0) * g01.first + (y - (double)y1) * g01.second;
+        const double n11 = (x - (double)x1) * g11.first + (y - (double)y1) * g11.second;
+
+        const double u = Curve::interpolate(0.0, 1.0, sx), v = Curve::interpolate(0.0, 1.0, sy);
+        const double du = Curve::slope(sx), dv = Curve::slope(sy);
+        const double a = n10 - n00, b = n01 - n00, c = n00 - n10 - n01 + n11;
+
+        dx = g00.first  + u * (g10.first  - g00.first)  + v * (g01.first  - g00.first)  + u * v * (g00.first  - g10.first  - g01.first  + g11.first)  + du * (a + c * v);
+        dy = g00.second + u * (g10.second - g00.second) + v * (g01.second - g00.second) + u * v * (g00.second - g10.second - g01.second + g11.second) + dv * (b + c * u);
+        return Curve::interpolate(Curve::interpolate(n00, n10, sx), Curve::interpolate(n01, n11, sx), sy);
+    }
+};
+
+/** Simplex kernel; samples the three corners of the skewed triangle around the point instead of a square's four
+ * Gradients come from a fixed table of 24 directions rather than randomGradient()'s trigonometry    */
+struct SimplexKernel {
+    static const double* gradient(const int &ix, const int &iy) {
+        static const double gradients[24][2] = {
+            { 1.00000000000000000000,  0.00000000000000000000}, { 0.96592582628906828675,  0.25881904510252076235}, { 0.86602540378443864676,  0.50000000000000000000}, { 0.70710678118654752440,  0.70710678118654752440},
+            { 0.50000000000000000000,  0.86602540378443864676}, { 0.25881904510252076235,  0.96592582628906828675}, { 0.00000000000000000000,  1.00000000000000000000}, {-0.25881904510252076235,  0.96592582628906828675},
+            {-0.50000000000000000000,  0.86602540378443864676}, {-0.70710678118654752440,  0.70710678118654752440}, {-0.86602540378443864676,  0.50000000000000000000}, {-0.96592582628906828675,  0.25881904510252076235},
+            {-1.00000000000000000000,  0.00000000000000000000}, {-0.96592582628906828675, -0.25881904510252076235}, {-0.86602540378443864676, -0.50000000000000000000}, {-0.70710678118654752440, -0.70710678118654752440},
+            {-0.50000000000000000000, -0.86602540378443864676}, {-0.25881904510252076235, -0.96592582628906828675}, { 0.00000000000000000000, -1.00000000000000000000}, { 0.25881904510252076235, -0.96592582628906828675},
+            { 0.50000000000000000000, -0.86602540378443864676}, { 0.70710678118654752440, -0.70710678118654752440}, { 0.86602540378443864676, -0.50000000000000000000}, { 0.96592582628906828675, -0.25881904510252076235}
+        };
+
+        return gradients[latticeHash(ix, iy) % 24];
+    }
+
+    static double corner(const int &ix, const int &iy, const double &x, const double &y) {
+        const double t = 0.5 - x * x - y * y;
+        if (t <= 0.0) {return 0.0;}
+        const double* g = gradient(ix, iy);
+        return t * t * t * t * (x * g[0] + y * g[1]);
+    }
+    /** A corner's contribution, adding its partial derivatives onto dx & dy */
+    static double corner(const int &ix, const int &iy, const double &x, const double &y, double &dx, double &dy) {
+        const double t = 0.5 - x * x - y * y;
+        if (t <= 0.0) {return 0.0;}
+        const double* g = gradient(ix, iy);
+        const double t3 = t * t * t, dot = x * g[0] + y * g[1];
+        dx += t3 * (t * g[0] - 8.0 * x * dot);
+        dy += t3 * (t * g[1] - 8.0 * y * dot);
+        return t3 * t * dot;
+    }
 
+    static double sample(double x, double y) {
+        const double F2 = 0.36602540378443864676, G2 = 0.21132486540518711775;
+
+        // Stretch the lattice so features come out about the same size as the Perlin kernel's (an empirical factor, not derived)
+        x *= 0.625;
+        y *= 0.625;
+
+        const double s = (x + y) * F2;
+        const int i = (int)std::floor(x + s), j = (int)std::floor(y + s);
+        const double t = (i + j) * G2;
+        const double x0 = x - (i - t), y0 = y - (j - t);
+
+        const int i1 = x0 > y0 ? 1 : 0, j1 = 1 - i1;
+        const double x1 = x0 - i1 + G2, y1 = y0 - j1 + G2;
+        const double x2 = x0 - 1.0 + 2.0 * G2, y2 = y0 - 1.0 + 2.0 * G2;
+
+        // Scaled so the output has about the same spread as the Perlin kernel's (also empirical; the exact bound of this kernel is not guaranteed to fit [-1, 1])
+        return 40.0 * (corner(i, j, x0, y0) + corner(i + i1, j + j1, x1, y1) + corner(i + 1, j + 1, x2, y2));
+    }
+
+    /** Sample the kernel along with its analytic partial derivatives; the value matches sample() exactly */
+    static double sample(const double &x, const double &y, double &dx, double &dy) {
+        const double F2 = 0.36602540378443864676, G2 = 0.21132486540518711775;
+        const double sx = x * 0.625, sy = y * 0.625;
+
+        const double s = (sx + sy) * F2;
+        const int i = (int)std::floor(sx + s), j = (int)std::floor(sy + s);
+        const double t = (i + j) * G2;
+        const double x0 = sx - (i - t), y0 = sy - (j - t);
+
+        const int i1 = x0 > y0 ? 1 : 0, j1 = 1 - i1;
+
+        dx = 0.0;
+        dy = 0.0;
+        const double value = corner(i, j, x0, y0, dx, dy) + corner(i + i1, j + j1, x0 - i1 + G2, y0 - j1 + G2, dx, dy) + corner(i + 1, j + 1, x0 - 1.0 + 2.0 * G2, y0 - 1.0 + 2.0 * G2, dx, dy);
+
+        // The skew only shifts which corners are used; each corner's offset moves 1:1 with the (stretched) input
+        dx *= 40.0 * 0.625;
+        dy *= 40.0 * 0.625;
+        return 40.0 * value;
+    }
+};
+
+inline double perlin(double x, double y) {
     // Range from [-1, 1]
-    return interpolate(interpolate(dotGridGradient(x0, y0, x, y), dotGridGradient(x1, y0, x, y), sx), interpolate(dotGridGradient(x0, y1, x, y), dotGridGradient(x1, y1, x, y), sx), y - (double)y0);
+    return PerlinKernel<PerlinQuintic>::sample(x, y);
     // Range from [0, 1]
-    // return interpolate(interpolate(dotGridGradient(x0, y0, x, y), dotGridGradient(x1, y0, x, y), sx), interpolate(dotGridGradient(x0, y1, x, y), dotGridGradient(x1, y1, x, y), sx), y - (double)y0) * 0.5 + 0.5;
+    // return PerlinKernel<PerlinQuintic>::sample(x, y) * 0.5 + 0.5;
+}
+
+/** Clamp a summed octave value to [-1, 1] and remap it to [0, 1] */
+inline double finishNoise(double val) {
+    if (val > 1.0) {val = 1.0;}
+    else if (val < -1.0) {val = -1.0;}
+
+    return val * 0.5 + 0.5;
+}
+
+/** Frequency of octave k for a compile-time bias */
+constexpr double octaveFreq(const double bias, const int k) {
+    double output = 1.0;
+    for (int i = 0; i < k; i++) {output *= bias;}
+    return output;
+}
+/** Amplitude of octave k for a compile-time bias */
+constexpr double octaveAmp(const double bias, const int k) {
+    double output = 1.0;
+    for (int i = 0; i < k; i++) {output /= bias;}
+    return output;
+}
+
+/** Unrolled octave sum; octave K adds onto the running value in the same order as the runtime loop */
+template <typename Kernel, int K, int Octaves, int Bias> struct PerlinOctaves {
+    static double sum(const double &val, const double &row, const double &col, const double &scale) {
+        constexpr double freq = octaveFreq(Bias, K), amp = octaveAmp(Bias, K);
+        return PerlinOctaves<Kernel, K + 1, Octaves, Bias>::sum(val + Kernel::sample(row * freq / scale, col * freq / scale) * amp, row, col, scale);
+    }
+};
+template <typename Kernel, int Octaves, int Bias> struct PerlinOctaves<Kernel, Octaves, Octaves, Bias> {
+    static double sum(const double &val, const double &, const double &, const double &) {return val;}
+};
+
+/** Signature shared by every noise sampler, so generators can pick a specialisation once per grid */
+typedef double (*NoiseSampler)(const long long &row, const long long &col, const int &o, const double &bias, const double &scale);
+
+/** Sample the octave noise for a single cell with the octave count and bias known at runtime */
+template <typename Kernel> inline double noiseSampleRuntime(const long long &row, const long long &col, const int &o, const double &bias, const double &scale) {
+    double val = 0.0, freq = 1.0, amp = 1.0;
+
+    for (int k = 0; k < o; k++) {
+        val += Kernel::sample(row * freq / scale, col * freq / scale) * amp;
+
+        freq *= bias;
+        amp /= bias;
+    }
+
+    return finishNoise(val);
+}
+/** Sample the octave noise for a single cell with the octave count and bias fixed at compile time (o & bias are ignored) */
+template <typename Kernel, int Octaves, int Bias> inline double noiseSampleFixed(const long long &row, const long long &col, const int &, const double &, const double &scale) {
+    return finishNoise(PerlinOctaves<Kernel, 0, Octaves, Bias>::sum(0.0, (double)row, (double)col, scale));
 }
 
-std::vector<std::vector<double>> getNoiseGrid(int w, int h, int o = 8, double bias = 2.0, double scale = 350.0) {
-    std::vector<std::vector<double>> output;
+template <typename Kernel> inline NoiseSampler getNoiseSampler(const int &o, const double &bias) {
+    if (bias == 2.0) {
+        switch (o) {
+            case 1: return &noiseSampleFixed<Kernel, 1, 2>;
+            case 2: return &noiseSampleFixed<Kernel, 2, 2>;
+            case 3: return &noiseSampleFixed<Kernel, 3, 2>;
+            case 4: return &noiseSampleFixed<Kernel, 4, 2>;
+            case 5: return &noiseSampleFixed<Kernel, 5, 2>;
+            case 6: return &noiseSampleFixed<Kernel, 6, 2>;
+            case 7: return &noiseSampleFixed<Kernel, 7, 2>;
+            case 8: return &noiseSampleFixed<Kernel, 8, 2>;
+        }
+    }
+    return &noiseSampleRuntime<Kernel>;
+}
+/** Pick the noise sampler for a set of parameters
+ * Octave counts of 1-8 with a bias of 2 get a fully unrolled specialisation, everything else falls back to the runtime loop
+ * @param o Number of octaves
+ * @param bias Frequency multiplier (and amplitude divisor) between octaves
+ * @param interp Interpolation curve; either PERLIN_INTERP_LINEAR, PERLIN_INTERP_CUBIC or PERLIN_INTERP_QUINTIC (unused by the simplex kernel)
+ * @param kernel Noise kernel; either NOISE_KERNEL_PERLIN or NOISE_KERNEL_SIMPLEX    */
+inline NoiseSampler getNoiseSampler(const int &o, const double &bias, const unsigned char &interp = PERLIN_INTERP_QUINTIC, const unsigned char &kernel = NOISE_KERNEL_PERLIN) {
+    if (kernel == NOISE_KERNEL_SIMPLEX) {return getNoiseSampler<SimplexKernel>(o, bias);}
+    switch (interp) {
+        case PERLIN_INTERP_LINEAR: return getNoiseSampler<PerlinKernel<PerlinLinear>>(o, bias);
+        case PERLIN_INTERP_CUBIC:  return getNoiseSampler<PerlinKernel<PerlinCubic>>(o, bias);
+    }
+    return getNoiseSampler<PerlinKernel<PerlinQuintic>>(o, bias);
+}
+
+/** Signature shared by the partial octave summers used to refine a coarse sample with more octaves */
+typedef double (*OctaveAccumulator)(double val, const long long &row, const long long &col, const int &first, const int &last, const double &bias, const double &scale);
 
-    for (int i = 0; i < h; i++) {
-        output.emplace_back();
+/** Add octaves [first, last) of a cell onto a running (unclamped) octave sum
+ * Summing [0, k) then [k, o) gives exactly the same value as summing [0, o) in one go; pass the total through finishNoise() at the end    */
+template <typename Kernel> inline double accumulateOctaves(double val, const long long &row, const long long &col, const int &first, const int &last, const double &bias, const double &scale) {
+    double freq = 1.0, amp = 1.0;
+    for (int k = 0; k < first; k++) {
+        freq *= bias;
+        amp /= bias;
+    }
+
+    for (int k = first; k < last; k++) {
+        val += Kernel::sample(row * freq / scale, col * freq / scale) * amp;
+
+        freq *= bias;
+        amp /= bias;
+    }
+    return val;
+}
+inline OctaveAccumulator getOctaveAccumulator(const unsigned char &interp = PERLIN_INTERP_QUINTIC, const unsigned char &kernel = NOISE_KERNEL_PERLIN) {
+    if (kernel == NOISE_KERNEL_SIMPLEX) {return &accumulateOctaves<SimplexKernel>;}
+    switch (interp) {
+        case PERLIN_INTERP_LINEAR: return &accumulateOctaves<PerlinKernel<PerlinLinear>>;
+        case PERLIN_INTERP_CUBIC:  return &accumulateOctaves<PerlinKernel<PerlinCubic>>;
+    }
+    return &accumulateOctaves<PerlinKernel<PerlinQuintic>>;
+}
+
+/** Sample the octave noise for a single cell of a noise grid
+ * @param row Row of the cell
+ * @param col Column of the cell
+ * @param o Number of octaves
+ * @param bias Frequency multiplier (and amplitude divisor) between octaves
+ * @param scale Size of the base octave in cells
+ * @returns A value in the range [0, 1]    */
+inline double noiseSample(const long long &row, const long long &col, const int &o, const double &bias, const double &scale) {return noiseSampleRuntime<PerlinKernel<PerlinQuintic>>(row, col, o, bias, scale);}
+
+/** Generate a noise grid across several threads, each row allocated up front & filled in place
+ * Every cell is sampled exactly as noiseSample() would, so the values don't depend on the number of threads
+ * @param threads Number of worker threads; 0 uses every available core    */
+inline std::vector<std::vector<double>> getNoiseGrid(int w, int h, int o = 8, double bias = 2.0, double scale = 350.0, unsigned char interp = PERLIN_INTERP_QUINTIC, unsigned char kernel = NOISE_KERNEL_PERLIN, unsigned int threads = 0) {
+    if (w <= 0 || h <= 0) {return {};}
+    const NoiseSampler sample = getNoiseSampler(o, bias, interp, kernel);
+    std::vector<std::vector<double>> output(h, std::vector<double>(w));
+
+    forEachRowBand(h, threads, [&](const int &i) {
+        double* row = output[i].data();
         for (int j = 0; j < w; j++) {
-            double val = 0.0, freq = 1.0, amp = 1.0;
+            row[j] = sample(i, j, o, bias, scale);
+        }
+    });
 
-            for (int k = 0; k < o; k++) {
-                val += perlin(i * freq / scale, j * freq / scale) * amp;
+    return output;
+}
 
-                freq *= bias;
-                amp /= bias;
-            }
+/** Generate a noise grid across several threads, writing straight into one contiguous buffer
+ * Rows are handed out to the workers in bands, so the values are identical to getNoiseGrid()
+ * @param w Width of the grid in cells
+ * @param h Height of the grid in cells
+ * @param o Number of octaves
+ * @param bias Frequency multiplier (and amplitude divisor) between octaves
+ * @param scale Size of the base octave in cells
+ * @param interp Interpolation curve; either PERLIN_INTERP_LINEAR, PERLIN_INTERP_CUBIC or PERLIN_INTERP_QUINTIC
+ * @param kernel Noise kernel; either NOISE_KERNEL_PERLIN or NOISE_KERNEL_SIMPLEX
+ * @param threads Number of worker threads; 0 uses every available core
+ * @returns The grid in row-major order (cell [i][j] is at index i * w + j)    */
+inline std::vector<double> getNoiseBuffer(int w, int h, int o = 8, double bias = 2.0, double scale = 350.0, unsigned char interp = PERLIN_INTERP_QUINTIC, unsigned char kernel = NOISE_KERNEL_PERLIN, unsigned int threads = 0) {
+    if (w <= 0 || h <= 0) {return {};}
+    const NoiseSampler sample = getNoiseSampler(o, bias, interp, kernel);
+    std::vector<double> output((unsigned long int)w * h);
 
-            if (val > 1.0) {val = 1.0;}
-            else if (val < -1.0) {val = -1.0;}
+    forEachRowBand(h, threads, [&](const int &i) {
+        double* row = output.data() + (unsigned long int)i * w;
+        for (int j = 0; j < w; j++) {
+            row[j] = sample(i, j, o, bias, scale);
+        }
+    });
+
+    return output;
+}
+
+struct NoiseStats {
+    double Min = 0.0, Max = 0.0, Mean = 0.0, StdDev = 0.0;
+    // Mean absolute difference between horizontally & vertically adjacent cells; a measure of how rough the terrain looks
+    double Roughness = 0.0;
+};
 
-            output[i].emplace_back(val * 0.5 + 0.5);
+/** Gather value & roughness statistics for a row-major noise buffer, used to compare the output of different kernels
+ * @param buffer Row-major grid (as from getNoiseBuffer())
+ * @param w Width of the grid in cells    */
+inline NoiseStats getNoiseStats(const std::vector<double> &buffer, const int &w) {
+    NoiseStats output;
+    if (buffer.empty() || w <= 0) {return output;}
+    const unsigned long int h = buffer.size() / w;
+
+    output.Min = output.Max = buffer[0];
+    double sum = 0.0, sumSq = 0.0, diff = 0.0;
+    unsigned long int pairs = 0;
+    for (unsigned long int i = 0; i < h; i++) {
+        for (unsigned long int j = 0; j < (unsigned long int)w; j++) {
+            const double val = buffer[i * w + j];
+            output.Min = std::min(output.Min, val);
+            output.Max = std::max(output.Max, val);
+            sum += val;
+            sumSq += val * val;
+            if (j + 1 < (unsigned long int)w) {diff += std::fabs(buffer[i * w + j + 1] - val); pairs++;}
+            if (i + 1 < h) {diff += std::fabs(buffer[(i + 1) * w + j] - val); pairs++;}
         }
     }
 
+    const double count = (double)(h * w);
+    output.Mean = sum / count;
+    output.StdDev = std::sqrt(std::max(0.0, sumSq / count - output.Mean * output.Mean));
+    output.Roughness = pairs > 0 ? diff / pairs : 0.0;
+    return output;
+}
+
+/** Signature shared by the noise samplers that also produce the gradient of the noise */
+typedef double (*NoiseGradientSampler)(const long long &row, const long long &col, const int &o, const double &bias, const double &scale, double &dx, double &dy);
+
+/** Sample the octave noise for a single cell along with its analytic gradient
+ * @param dx Set to the change in value per cell along the row (towards higher columns)
+ * @param dy Set to the change in value per cell down the column (towards higher rows)
+ * @returns The same value as noiseSampleRuntime()    */
+template <typename Kernel> inline double noiseSampleGradient(const long long &row, const long long &col, const int &o, const double &bias, const double &scale, double &dx, double &dy) {
+    double val = 0.0, freq = 1.0, amp = 1.0, rowSlope = 0.0, colSlope = 0.0;
+
+    for (int k = 0; k < o; k++) {
+        double kRow, kCol;
+        val += Kernel::sample(row * freq / scale, col * freq / scale, kRow, kCol) * amp;
+        rowSlope += kRow * freq / scale * amp;
+        colSlope += kCol * freq / scale * amp;
+
+        freq *= bias;
+        amp /= bias;
+    }
+
+    // Clamped cells are flat
+    const bool clamped = val > 1.0 || val < -1.0;
+    dx = clamped ? 0.0 : colSlope * 0.5;
+    dy = clamped ? 0.0 : rowSlope * 0.5;
+    return finishNoise(val);
+}
+inline NoiseGradientSampler getNoiseGradientSampler(const unsigned char &interp = PERLIN_INTERP_QUINTIC, const unsigned char &kernel = NOISE_KERNEL_PERLIN) {
+    if (kernel == NOISE_KERNEL_SIMPLEX) {return &noiseSampleGradient<SimplexKernel>;}
+    switch (interp) {
+        case PERLIN_INTERP_LINEAR: return &noiseSampleGradient<PerlinKernel<PerlinLinear>>;
+        case PERLIN_INTERP_CUBIC:  return &noiseSampleGradient<PerlinKernel<PerlinCubic>>;
+    }
+    return &noiseSampleGradient<PerlinKernel<PerlinQuintic>>;
+}
+
+/** Noise grid with its gradient, stored as separate row-major planes */
+struct NoisePlanes {
+    int W = 0, H = 0;
+    std::vector<double> Value;
+    // Change in value per cell towards higher columns
+    std::vector<double> DX;
+    // Change in value per cell towards higher rows
+    std::vector<double> DY;
+};
+
+/** Fill one row of a set of noise planes that has already been sized
+ * @param i Row of the planes to fill
+ * @param originRow World row of the planes' top-left cell
+ * @param originCol World column of the planes' top-left cell    */
+inline void fillNoisePlanesRow(NoisePlanes &planes, const NoiseGradientSampler &sample, const int &i, const int &o, const double &bias, const double &scale, const long long &originRow = 0, const long long &originCol = 0) {
+    const unsigned long int offset = (unsigned long int)i * planes.W;
+    double* value = planes.Value.data() + offset;
+    double* dx = planes.DX.data() + offset;
+    double* dy = planes.DY.data() + offset;
+    for (int j = 0; j < planes.W; j++) {value[j] = sample(originRow + i, originCol + j, o, bias, scale, dx[j], dy[j]);}
+}
+
+/** Generate a noise grid together with its analytic gradient in one pass, across several threads
+ * Values are identical to getNoiseBuffer(); gradients are in value units (0-1) per cell, so multiply by the height range when mapping onto a grid
+ * @param w Width of the grid in cells
+ * @param h Height of the grid in cells
+ * @param o Number of octaves
+ * @param bias Frequency multiplier (and amplitude divisor) between octaves
+ * @param scale Size of the base octave in cells
+ * @param interp Interpolation curve; either PERLIN_INTERP_LINEAR, PERLIN_INTERP_CUBIC or PERLIN_INTERP_QUINTIC
+ * @param kernel Noise kernel; either NOISE_KERNEL_PERLIN or NOISE_KERNEL_SIMPLEX
+ * @param threads Number of worker threads; 0 uses every available core
+ * @param originRow World row of the grid's top-left cell
+ * @param originCol World column of the grid's top-left cell    */
+inline NoisePlanes getNoisePlanes(int w, int h, int o = 8, double bias = 2.0, double scale = 350.0, unsigned char interp = PERLIN_INTERP_QUINTIC, unsigned char kernel = NOISE_KERNEL_PERLIN, unsigned int threads = 0, long long originRow = 0, long long originCol = 0) {
+    NoisePlanes output;
+    if (w <= 0 || h <= 0) {return output;}
+    output.W = w;
+    output.H = h;
+    output.Value.resize((unsigned long int)w * h);
+    output.DX.resize((unsigned long int)w * h);
+    output.DY.resize((unsigned long int)w * h);
+
+    const NoiseGradientSampler sample = getNoiseGradientSampler(interp, kernel);
+    forEachRowBand(h, threads, [&](const int &i) {fillNoisePlanesRow(output, sample, i, o, bias, scale, originRow, originCol);});
+
     return output;
 }
 
@@ -0,0 +1,204 @@
+#ifndef PROGRESSIVENOISE
+#define PROGRESSIVENOISE
+
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+
+#include "Perlin.hpp"
+
+/** Generates a noise grid coarse-to-fine on a background thread so a preview is available almost immediately
+ * Each level is written into one preallocated buffer by row bands spread over every core (see getNoiseBuffer()). Every level halves the sample spacing; samples shared with the previous level only get the extra detail octaves added on top,
+ * and octaves finer than a level's spacing are left out until a level can show them. The final level matches getNoiseGrid()    */
+class ProgressiveNoise {
+    public:
+        struct Level {
+            unsigned long int Generation = 0;
+            // Distance between samples in cells; sample [i][j] covers cells [i * Step, (i + 1) * Step) x [j * Step, (j + 1) * Step)
+            int Step = 1;
+            int W = 0, H = 0;
+            // Width & height of the full-resolution grid this level previews
+            int GridW = 0, GridH = 0;
+            bool Final = false;
+            std::vector<double> Values;
+            // Analytic gradient of the final level in value units per cell (see getNoisePlanes()); only filled in when asked for
+            std::vector<double> DX, DY;
+        };
+
+    private:
+        struct Params {
+            int W, H, Octaves, Coarsest;
+            unsigned int Threads;
+            double Bias, Scale;
+            long long OriginRow, OriginCol;
+            OctaveAccumulator Accumulate;
+            // Sampler for the final level when it has to come with its gradient; NULL otherwise
+            NoiseGradientSampler Gradient;
+        };
+
+        std::thread Worker;
+        std::atomic<bool> Cancelled;
+        std::atomic<bool> Running;
+        unsigned long int Generation = 0;
+
+        std::mutex MailboxLock;
+        Level Mailbox;
+        bool HasLevel = false;
+
+        /** Number of octaves whose wavelength is at least the sample spacing (always at least one) */
+        static int octavesFor(const Params &params, const int &step) {
+            if (step <= 1) {return params.Octaves;}
+            int output = 0;
+            double wavelength = params.Scale;
+            while (output < params.Octaves && wavelength >= step) {
+                output++;
+                wavelength /= params.Bias;
+            }
+            return output > 0 ? output : 1;
+        }
+
+        void run(const Params params, const unsigned long int generation) {
+            std::vector<double> raw, prevRaw;
+            int prevStep = 0, prevW = 0, prevOctaves = 0;
+
+            for (int step = params.Coarsest; step >= 1; step /= 2) {
+                const int w = (params.W + step - 1) / step, h = (params.H + step - 1) / step;
+                const int octaves = octavesFor(params, step);
+                const bool refine = prevStep == step * 2;
+
+                // A final level with a gradient is sampled whole in the same pass as its gradient rather than refined, giving the same values
+                if (step == 1 && params.Gradient != NULL) {
+                    NoisePlanes planes;
+                    planes.W = w;
+                    planes.H = h;
+                    planes.Value.resize((unsigned long int)w * h);
+                    planes.DX.resize((unsigned long int)w * h);
+                    planes.DY.resize((unsigned long int)w * h);
+                    forEachRowBand(h, params.Threads, [&](const int &i) {
+                        if (Cancelled) {return;}
+                        fillNoisePlanesRow(planes, params.Gradient, i, params.Octaves, params.Bias, params.Scale, params.OriginRow, params.OriginCol);
+                    });
+                    if (Cancelled) {break;}
+
+                    Level level;
+                    level.Generation = generation;
+                    level.W = w;
+                    level.H = h;
+                    level.GridW = params.W;
+                    level.GridH = params.H;
+                    level.Final = true;
+                    level.Values.swap(planes.Value);
+                    level.DX.swap(planes.DX);
+                    level.DY.swap(planes.DY);
+
+                    std::lock_guard<std::mutex> lock(MailboxLock);
+                    Mailbox = std::move(level);
+                    HasLevel = true;
+                    break;
+                }
+
+                raw.assign((unsigned long int)w * h, 0.0);
+                forEachRowBand(h, params.Threads, [&](const int &i) {
+                    // Bands still queued once cancelled are skipped, so cancelling doesn't wait for the whole level
+                    if (Cancelled) {return;}
+                    const long long row = params.OriginRow + (long long)i * step;
+                    double* out = raw.data() + (unsigned long int)i * w;
+                    for (int j = 0; j < w; j++) {
+                        const long long col = params.OriginCol + (long long)j * step;
+                        if (refine && i % 2 == 0 && j % 2 == 0) {
+                            out[j] = params.Accumulate(prevRaw[(unsigned long int)(i / 2) * prevW + j / 2], row, col, prevOctaves, octaves, params.Bias, params.Scale);
+                        } else {
+                            out[j] = params.Accumulate(0.0, row, col, 0, octaves, params.Bias, params.Scale);
+                        }
+                    }
+                });
+                if (Cancelled) {
+                    Running = false;
+                    return;
+                }
+
+                Level level;
+                level.Generation = generation;
+                level.Step = step;
+                level.W = w;
+                level.H = h;
+                level.GridW = params.W;
+                level.GridH = params.H;
+                level.Final = step == 1;
+                level.Values.resize(raw.size());
+                for (unsigned long int i = 0; i < raw.size(); i++) {level.Values[i] = finishNoise(raw[i]);}
+
+                {
+                    std::lock_guard<std::mutex> lock(MailboxLock);
+                    Mailbox = std::move(level);
+                    HasLevel = true;
+                }
+
+                prevRaw.swap(raw);
+                prevStep = step;
+                prevW = w;
+                prevOctaves = octaves;
+            }
+            Running = false;
+        }
+
+    public:
+        ProgressiveNoise() : Cancelled(false), Running(false) {}
+        ~ProgressiveNoise() {cancel();}
+
+        ProgressiveNoise(const ProgressiveNoise&) = delete;
+        ProgressiveNoise& operator=(const ProgressiveNoise&) = delete;
+
+        /** Start generating a new grid, cancelling whatever was being generated before
+         * @param w Width of the grid in cells
+         * @param h Height of the grid in cells
+         * @param o Number of octaves
+         * @param bias Frequency multiplier (and amplitude divisor) between octaves
+         * @param scale Size of the base octave in cells
+         * @param interp Interpolation curve; either PERLIN_INTERP_LINEAR, PERLIN_INTERP_CUBIC or PERLIN_INTERP_QUINTIC
+         * @param kernel Noise kernel; either NOISE_KERNEL_PERLIN or NOISE_KERNEL_SIMPLEX
+         * @param coarsest Sample spacing of the first preview (rounded down to a power of two)
+         * @param originRow World row of the grid's top-left cell
+         * @param originCol World column of the grid's top-left cell
+         * @param threads Number of worker threads each level is split over; 0 uses every available core
+         * @param gradient Whether the final level should come with the analytic gradient of the noise
+         * @returns The generation number attached to every level of this grid    */
+        unsigned long int start(const int &w, const int &h, const int &o = 8, const double &bias = 2.0, const double &scale = 350.0, const unsigned char &interp = PERLIN_INTERP_QUINTIC, const unsigned char &kernel = NOISE_KERNEL_PERLIN, const int &coarsest = 8, const long long &originRow = 0, const long long &originCol = 0, const unsigned int &threads = 0, const bool &gradient = false) {
+            cancel();
+
+            int step = 1;
+            while (step * 2 <= coarsest) {step *= 2;}
+            const Params params = {w > 0 ? w : 0, h > 0 ? h : 0, o, step, threads, bias, scale, originRow, originCol, getOctaveAccumulator(interp, kernel), gradient ? getNoiseGradientSampler(interp, kernel) : NULL};
+
+            Cancelled = false;
+            Running = true;
+            Worker = std::thread(&ProgressiveNoise::run, this, params, ++Generation);
+            return Generation;
+        }
+
+        /** Stop the current generation and drop any level that has not been collected yet */
+        void cancel() {
+            Cancelled = true;
+            if (Worker.joinable()) {Worker.join();}
+            Running = false;
+
+            std::lock_guard<std::mutex> lock(MailboxLock);
+            HasLevel = false;
+        }
+
+        bool isRunning() const {return Running;}
+
+        /** Collect the most recent finished level; intermediate levels that were never collected are skipped
+         * @param level Overwritten with the level if one is available
+         * @returns Whether a new level was available    */
+        bool poll(Level &level) {
+            std::lock_guard<std::mutex> lock(MailboxLock);
+            if (!HasLevel) {return false;}
+            level = std::move(Mailbox);
+            HasLevel = false;
+            return true;
+        }
+};
+
+#endif /* PROGRESSIVENOISE */
@@ -0,0 +1,77 @@
+#ifndef RASTER
+#define RASTER
+
+#include <SDL2/SDL.h>
+#include <vector>
+
+#define LINE_OVERLAP_NONE  0x00    // No line overlap, like in standard Bresenham
+#define LINE_OVERLAP_MAJOR 0x01    // Overlap - first go major then minor direction. Pixel is drawn as extension after actual line
+#define LINE_OVERLAP_MINOR 0x02    // Overlap - first go minor then major direction. Pixel is drawn as extension before next line
+#define LINE_OVERLAP_BOTH  0x03    // Overlap - both
+
+#define LINE_THICKNESS_MIDDLE 0                 // Start point is on the line at center of the thick line
+#define LINE_THICKNESS_DRAW_CLOCKWISE 1         // Start point is on the counter clockwise border line
+#define LINE_THICKNESS_DRAW_COUNTERCLOCKWISE 2  // Start point is on the clockwise border line
+
+/** An ARGB8888 pixel buffer in main memory that shapes are rasterised straight into
+ * Coordinates are in pixels from the top-left corner with y pointing down; anything outside the buffer is clipped.
+ * Pixels are overwritten rather than blended, and the area drawn to since the last clearDirty() is tracked so only that part has to be uploaded    */
+class Raster {
+    private:
+        int W = 0;
+        int H = 0;
+        std::vector<Uint32> Pixels;
+
+        // Bounding box of everything drawn since the last clearDirty(), inclusive; empty while DirtyX1 > DirtyX2
+        int DirtyX1 = 0;
+        int DirtyY1 = 0;
+        int DirtyX2 = -1;
+        int DirtyY2 = -1;
+
+        /** Grow the dirty area to cover a box, clipped to the buffer */
+        void touch(const int &x1, const int &y1, const int &x2, const int &y2);
+        void plot(const int &x, const int &y, const Uint32 &color) {
+            if (x >= 0 && x < W && y >= 0 && y < H) {Pixels[(unsigned long int)y * W + x] = color;}
+        }
+        /** Fill [x1, x2] on row y without touching the dirty area */
+        void span(int x1, int x2, const int &y, const Uint32 &color);
+        void line(const int &x1, const int &y1, const int &x2, const int &y2, const Uint32 &color);
+        void lineOverlap(const int &x1, const int &y1, const int &x2, const int &y2, const unsigned char &overlapType, const Uint32 &color);
+
+    public:
+        Raster(const int &w = 0, const int &h = 0);
+
+        /** Resize the buffer, clearing it to transparent */
+        void resize(const int &w, const int &h);
+        int getW() const;
+        int getH() const;
+        const Uint32* getPixels() const;
+        /** @returns The length of a row in bytes    */
+        int getPitch() const;
+
+        bool isDirty() const;
+        SDL_Rect getDirty() const;
+        /** Clear the dirty area back to transparent and forget about it */
+        void clearDirty();
+
+        static Uint32 pack(const SDL_Color &color);
+
+        void drawPixel(const int &x, const int &y, const SDL_Color &color);
+        /** Fill a horizontal run of pixels
+         * @param x1 First pixel of the run
+         * @param x2 Last pixel of the run, inclusive (may be left of x1)
+         * @param y Row of the run    */
+        void fillSpan(const int &x1, const int &x2, const int &y, const SDL_Color &color);
+        void fillRectangle(const SDL_Rect &rect, const SDL_Color &color);
+        void drawLine(const int &x1, const int &y1, const int &x2, const int &y2, const SDL_Color &color);
+        /** Draw a line with extra pixels drawn in if specified
+         * @param overlapType The kind of overlapping to do; either LINE_OVERLAP_NONE, LINE_OVERLAP_MAJOR, LINE_OVERLAP_MINOR, LINE_OVERLAP_BOTH    */
+        void drawLineOverlap(const int &x1, const int &y1, const int &x2, const int &y2, const unsigned char &overlapType, const SDL_Color &color);
+        /** Draw a line of any thickness without missing or repeating a pixel
+         * @param thicknessMode Side of the start point the thickness grows to; either LINE_THICKNESS_MIDDLE, LINE_THICKNESS_DRAW_CLOCKWISE, LINE_THICKNESS_DRAW_COUNTERCLOCKWISE    */
+        void drawThickLine(const int &x1, const int &y1, const int &x2, const int &y2, const int &thickness, const unsigned char &thicknessMode, const SDL_Color &color);
+        void drawCircle(const int &x, const int &y, const int &r, const SDL_Color &color);
+        void fillCircle(const int &x, const int &y, const int &r, const SDL_Color &color);
+};
+
+#endif /* RASTER */
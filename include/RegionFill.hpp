@@ -0,0 +1,141 @@
+#ifndef REGIONFILL
+#define REGIONFILL
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "Brush.hpp"
+
+#define REGION_TOLERANCE 0    // Cells within a tolerance of the seed's height
+#define REGION_REACHABLE 1    // Cells a path could reach from the seed moving between edge-sharing cells, under the same climb & drop limits as AStar_Grid
+
+#define REGION_SET   0    // Set every cell of the region to one height
+#define REGION_RAISE 1    // Add to every cell of the region (subtract if negative)
+
+/** Connected regions of a heightmap found with a scanline flood fill, then edited as a whole
+ * Regions are filled a run of cells at a time from an explicit stack with a bitset of visited cells, so there is no recursion
+ * and millions of cells take milliseconds; the region is kept as its runs so applying an edit only touches the cells in it    */
+class RegionFill {
+    public:
+        struct Span {
+            int Row = 0;
+            int First = 0, Last = 0;
+        };
+
+    private:
+        std::vector<std::uint64_t> Visited;
+        std::vector<Span> Stack;
+        std::vector<Span> Spans;
+        Brush::Area Bounds;
+        unsigned long int Cells = 0;
+        int W = 0;
+
+        bool isVisited(const int &row, const int &col) const {
+            const unsigned long int i = (unsigned long int)row * W + col;
+            return Visited[i >> 6] >> (i & 63) & 1;
+        }
+        /** Mark [first, last] of a row as visited a word at a time */
+        void mark(const int &row, const int &first, const int &last) {
+            unsigned long int i = (unsigned long int)row * W + first;
+            const unsigned long int end = (unsigned long int)row * W + last + 1;
+            while (i < end) {
+                const unsigned long int bit = i & 63, count = std::min<unsigned long int>(64 - bit, end - i);
+                Visited[i >> 6] |= (count == 64 ? ~(std::uint64_t)0 : (((std::uint64_t)1 << count) - 1)) << bit;
+                i += count;
+            }
+        }
+        void add(const int &row, const int &first, const int &last) {
+            mark(row, first, last);
+            Span span;
+            span.Row = row;
+            span.First = first;
+            span.Last = last;
+            Spans.push_back(span);
+            Stack.push_back(span);
+            Cells += last - first + 1;
+
+            Brush::Area area;
+            area.FirstRow = area.LastRow = row;
+            area.FirstCol = first;
+            area.LastCol = last;
+            Bounds.merge(area);
+        }
+
+    public:
+        /** Find the region around a seed cell, replacing the last one found
+         * @param rule Either REGION_TOLERANCE or REGION_REACHABLE
+         * @param tolerance Largest difference from the seed's height a cell can have (REGION_TOLERANCE only)
+         * @param maxAscend Largest climb between neighbouring cells (REGION_REACHABLE only)
+         * @param maxDescend Largest drop between neighbouring cells (REGION_REACHABLE only)
+         * @returns The number of cells in the region; 0 if the seed is off the grid    */
+        unsigned long int select(const std::vector<std::vector<double>> &grid, const int &row, const int &col, const unsigned char &rule, const double &tolerance, const double &maxAscend = 0.0, const double &maxDescend = 0.0) {
+            Spans.clear();
+            Stack.clear();
+            Bounds = Brush::Area();
+            Cells = 0;
+            if (row < 0 || row >= (int)grid.size() || col < 0 || col >= (int)grid[row].size()) {return 0;}
+
+            W = grid[0].size();
+            const int H = grid.size();
+            Visited.assign(((unsigned long int)W * H + 63) / 64, 0);
+
+            const double seed = grid[row][col];
+            // Whether a fill standing on a cell of height from may step onto a neighbour of height to
+            const auto passable = [&](const double &from, const double &to) {
+                if (rule == REGION_TOLERANCE) {return std::fabs(to - seed) <= tolerance;}
+                return to < from ? from - to <= maxDescend : to - from <= maxAscend;
+            };
+
+            const std::vector<double> &cells = grid[row];
+            int first = col, last = col;
+            while (first > 0 && passable(cells[first], cells[first - 1])) {first--;}
+            while (last + 1 < W && passable(cells[last], cells[last + 1])) {last++;}
+            add(row, first, last);
+
+            while (!Stack.empty()) {
+                const Span span = Stack.back();
+                Stack.pop_back();
+                const std::vector<double> &from = grid[span.Row];
+                for (int next = span.Row - 1; next <= span.Row + 1; next += 2) {
+                    if (next < 0 || next >= H) {continue;}
+                    const std::vector<double> &to = grid[next];
+                    int j = span.First;
+                    while (j <= span.Last) {
+                        if (isVisited(next, j) || !passable(from[j], to[j])) {
+                            j++;
+                            continue;
+                        }
+                        first = j;
+                        last = j;
+                        while (first > 0 && !isVisited(next, first - 1) && passable(to[first], to[first - 1])) {first--;}
+                        while (last + 1 < W && !isVisited(next, last + 1) && passable(to[last], to[last + 1])) {last++;}
+                        add(next, first, last);
+                        j = last + 1;
+                    }
+                }
+            }
+            return Cells;
+        }
+
+        const std::vector<Span>& getSpans() const {return Spans;}
+        unsigned long int getCells() const {return Cells;}
+        /** @returns The block of cells the region lies in; empty if there is no region    */
+        Brush::Area getBounds() const {return Bounds;}
+        bool contains(const int &row, const int &col) const {return !Spans.empty() && row >= 0 && col >= 0 && col < W && (unsigned long int)row * W + col < Visited.size() * 64 && isVisited(row, col);}
+
+        /** Edit every cell of the last region found
+         * @param op Either REGION_SET or REGION_RAISE
+         * @param value The height to set, or the amount to raise by
+         * @returns The block of cells that may have changed    */
+        Brush::Area apply(std::vector<std::vector<double>> &grid, const unsigned char &op, const double &value, const double &minVal, const double &maxVal) const {
+            for (unsigned long int i = 0; i < Spans.size(); i++) {
+                double* cells = grid[Spans[i].Row].data();
+                for (int j = Spans[i].First; j <= Spans[i].Last; j++) {cells[j] = std::min(std::max(op == REGION_SET ? value : cells[j] + value, minVal), maxVal);}
+            }
+            return Bounds;
+        }
+};
+
+#endif /* REGIONFILL */
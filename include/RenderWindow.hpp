@@ -5,33 +5,158 @@
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
 #include <iostream>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <functional>
+#include <string>
 
 #include "PresetColors.hpp"
 #include "Texture.hpp"
+#include "GlyphAtlas.hpp"
+#include "Raster.hpp"
+#include "HeightPyramid.hpp"
+#include "ColorRamp.hpp"
+#include "AStarRecorder.hpp"
 
-#define LINE_OVERLAP_NONE  0x00    // No line overlap, like in standard Bresenham
-#define LINE_OVERLAP_MAJOR 0x01    // Overlap - first go major then minor direction. Pixel is drawn as extension after actual line
-#define LINE_OVERLAP_MINOR 0x02    // Overlap - first go minor then major direction. Pixel is drawn as extension before next line
-#define LINE_OVERLAP_BOTH  0x03    // Overlap - both
+#define RENDER_BATCH_NONE     0    // Nothing queued
+#define RENDER_BATCH_POINTS   1    // Points of one color, flushed with SDL_RenderDrawPoints
+#define RENDER_BATCH_LINES    2    // A connected polyline of one color, flushed with SDL_RenderDrawLines
+#define RENDER_BATCH_OUTLINES 3    // Rectangle outlines of one color, flushed with SDL_RenderDrawRects
+#define RENDER_BATCH_FILLS    4    // Filled rectangles of any color, flushed as one vertex buffer with SDL_RenderGeometry
+#define RENDER_BATCH_TEXTURED 5    // Textured quads sharing one texture, flushed as one vertex buffer with SDL_RenderGeometry
+#define RENDER_BATCH_RASTER   6    // Shapes rasterised on the CPU into a window-sized buffer, flushed by uploading & copying the area drawn to
 
-#define LINE_THICKNESS_MIDDLE 0                 // Start point is on the line at center of the thick line
-#define LINE_THICKNESS_DRAW_CLOCKWISE 1         // Start point is on the counter clockwise border line
-#define LINE_THICKNESS_DRAW_COUNTERCLOCKWISE 2  // Start point is on the clockwise border line
+#define RENDER_HEADLESS_REFRESH_RATE 60    // Refresh rate reported by headless windows, which have no display to ask
+
+#define RENDER_DAMAGE_MAX_RECTS 8    // Damaged areas kept apart before they are all merged into their bounding box
 
 class RenderWindow {
     private:
         SDL_Window* Window;
         SDL_Renderer* Renderer;
+        // Frame drawn into by the software renderer when headless; NULL otherwise
+        SDL_Surface* Surface = NULL;
         int W;
         int H;
         int W_2;
         int H_2;
         bool IsFullscreen = false;
 
+        // Colors renderHeightView() draws heights with
+        ColorRamp GridRamp;
+
+        // What ViewTexture currently holds, so it is only refilled when something changes
+        SDL_Texture* ViewTexture = NULL;
+        int ViewTextureW = 0;
+        int ViewTextureH = 0;
+        const HeightPyramid* ViewSource = NULL;
+        unsigned long int ViewVersion = 0;
+        int ViewDepth = -1;
+        SDL_Rect ViewCells = {0, 0, 0, 0};
+        double ViewMin = 0.0;
+        double ViewMax = 0.0;
+        unsigned char ViewMode = PYRAMID_MEAN;
+
+        // What HeatTexture currently holds; one texel per visible cell (or block of cells when zoomed out)
+        SDL_Texture* HeatTexture = NULL;
+        int HeatTextureW = 0;
+        int HeatTextureH = 0;
+        const AStar_Recorder* HeatSource = NULL;
+        unsigned long int HeatSerial = 0;
+        unsigned long int HeatCount = 0;
+        SDL_Rect HeatCells = {0, 0, 0, 0};
+        int HeatStep = 0;
+        ColorRamp HeatRamp = ColorRamp(RAMP_HEAT);
+        // Per texel scratch kept between refreshes: rank of the first expansion (0 if none), the cell it was & whether it was looked at again
+        std::vector<unsigned long int> HeatOrder;
+        std::vector<unsigned long int> HeatFirst;
+        std::vector<unsigned char> HeatRepeated;
+
+        // What MaskTexture currently holds; one texel per visible cell (or block of cells when zoomed out)
+        SDL_Texture* MaskTexture = NULL;
+        int MaskTextureW = 0;
+        int MaskTextureH = 0;
+        const unsigned char* MaskSource = NULL;
+        unsigned long int MaskSerial = 0;
+        SDL_Rect MaskCells = {0, 0, 0, 0};
+        int MaskStep = 0;
+        Uint32 MaskColor = 0;
+
+        /** Find the cells of a heightmap that show up in an area, in blocks of step x step cells (step being the smallest power of two that keeps a block at least a pixel wide)
+         * @param cells Set to the visible blocks
+         * @returns Whether any are visible    */
+        bool visibleCells(const int &gridW, const int &gridH, const double &row, const double &col, const double &zoom, const SDL_Rect &dst, SDL_Rect &cells, int &step) const;
+        /** Make sure a streaming overlay texture can hold at least w x h texels, recreating it if not
+         * @param recreated Set when the texture was recreated, losing its contents
+         * @returns Whether the texture can be used    */
+        bool reserveOverlay(SDL_Texture* &texture, int &textureW, int &textureH, const int &w, const int &h, bool &recreated, const char* name);
+        /** Copy the blocks of cells held by an overlay texture onto the area they cover */
+        void drawOverlay(SDL_Texture* texture, const SDL_Rect &cells, const int &step, const double &row, const double &col, const double &zoom, const SDL_Rect &dst);
+
+        unsigned char BatchType = RENDER_BATCH_NONE;
+        SDL_Color BatchColor = {0, 0, 0, 0};
+        std::vector<SDL_Point> BatchPoints;
+        std::vector<SDL_Rect> BatchRects;
+        std::vector<SDL_Vertex> BatchVertices;
+        std::vector<int> BatchIndices;
+        SDL_Texture* BatchTexture = NULL;
+        unsigned long int DrawCalls = 0;
+        unsigned long int FrameDrawCalls = 0;
+
+        Uint64 LastShow = 0;
+        double FrameTime = 0.0;
+        unsigned long int FrameCount = 0;
+
+        /** Apply W & H to the window (headless frames keep their size) */
+        void applySize();
+
+        /** Make sure the open batch can take a primitive of the given kind & color, flushing it if not */
+        void batch(const unsigned char &type, const SDL_Color &color);
+        // The queue functions take renderer coordinates rather than the centered ones used by the public drawing functions
+        void queuePoint(const int &x, const int &y, const SDL_Color &color);
+        void queueLine(const int &x1, const int &y1, const int &x2, const int &y2, const SDL_Color &color);
+        void queueOutline(const SDL_Rect &rect, const SDL_Color &color);
+        void queueFill(const SDL_Rect &rect, const SDL_Color &color);
+        /** Queue pre-built textured geometry, offset by (x, y) and tinted with color */
+        void queueGeometry(SDL_Texture* texture, const std::vector<SDL_Vertex> &vertices, const std::vector<int> &indices, const float &x, const float &y, const SDL_Color &color);
+        /** Queue a texture from an atlas as a quad, rotated about its center & flipped the same way SDL_RenderCopyEx() would */
+        void queueSprite(const Texture &texture, const SDL_Rect &dst);
+
+        // Circles & overlap/thick lines cost a draw call per pixel or span on the GPU side, so they are rasterised here instead
+        Raster Overlay;
+        SDL_Texture* OverlayTexture = NULL;
+        /** Open (or continue) a raster batch, sizing the overlay to the window */
+        Raster& beginRaster();
+
+        std::unordered_map<TTF_Font*, std::unique_ptr<GlyphAtlas>> Atlases;
+
+        struct Layer {
+            SDL_Texture* Target = NULL;
+            bool Valid = false;
+        };
+        std::unordered_map<int, Layer> Layers;
+        int ActiveLayer = -1;
+
+        // Persistent copy of the window that repaint() redraws piecewise; the window itself is rebuilt from it every frame
+        SDL_Texture* BackBuffer = NULL;
+        // Target to go back to after drawing into a layer; either NULL (the window) or BackBuffer
+        SDL_Texture* FrameTarget = NULL;
+        std::vector<SDL_Rect> Damage;
+        bool Repainting = false;
+        SDL_Rect RepaintClip = {0, 0, 0, 0};
+
     public:
         RenderWindow(const char* title, const int &w, const int &h, Uint32 flags = SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
+        /** Create a headless window: an offscreen frame drawn by SDL's software renderer, with no display or GPU needed
+         * Everything is drawn exactly like in a normal window; frames can be written out with saveFrame(). Headless frames cannot be resized
+         * @param w Width of the frame in pixels
+         * @param h Height of the frame in pixels    */
+        RenderWindow(const int &w, const int &h);
         ~RenderWindow();
 
+        bool isHeadless() const;
+
         int getRefreshRate() const;
         Uint32 getWindowFlags();
 
@@ -54,6 +179,20 @@ class RenderWindow {
         void clear(const SDL_Color &color = PresetColors[COLOR_BLACK]);
         void show();
 
+        /** Submit every queued primitive to the renderer
+         * Primitives are queued by the drawing functions and flushed automatically before anything else is drawn, so this is only needed when drawing to the renderer directly    */
+        void flushBatch();
+        /** @returns The number of SDL draw calls issued during the last frame (up to the last show())    */
+        unsigned long int getDrawCalls() const;
+        /** @returns Seconds between the last two calls to show()    */
+        double getFrameTime() const;
+        /** @returns The number of frames shown so far    */
+        unsigned long int getFrameCount() const;
+        /** Write the current frame to a PNG file
+         * Reads the back buffer used by repaint() if there is one, the headless frame if headless, and otherwise whatever has been drawn since the last show()
+         * @returns Whether the file was written    */
+        bool saveFrame(const std::string &path);
+
         bool toggleFullscreen(const bool &trueFullscreen = true);
         void centerMouse();
 
@@ -76,14 +215,108 @@ class RenderWindow {
         void fillCircle(const int &x, const int &y, const int &r, const SDL_Color &color = PresetColors[COLOR_WHITE]);
 
         SDL_Texture* loadTexture(const std::string &path);
+        /** Pack the images added to an atlas into a texture for this window
+         * @returns Whether the texture was created    */
+        bool packAtlas(TextureAtlas &atlas);
 
         void renderTexture(SDL_Texture* texture, const SDL_Rect &src, const SDL_Rect &dst);
         void renderTexture(SDL_Texture* texture, const SDL_Rect &src, const SDL_Rect &dst, const double &angle, const SDL_Point &center, const SDL_RendererFlip &flip);
+        /** Draw a texture with its own frame, center, angle, flip & mods
+         * Textures from an atlas are queued, so consecutive sprites from the same atlas cost one draw call between them    */
         void renderTexture(const Texture &texture, const SDL_Rect &dst);
         void renderTexture(const Texture &texture, const SDL_Point &pos);
         void renderTexture(const Texture &texture, const int &x, const int &y);
 
+        /** Choose the colors heightmaps are drawn with, redrawing them from scratch
+         * @param type Either RAMP_GREYSCALE, RAMP_HYPSOMETRIC or RAMP_SLOPE    */
+        void setGridRamp(const unsigned char &type);
+        unsigned char getGridRamp() const;
+
+        /** Start redrawing a retained layer if its contents are out of date
+         * A layer is a window-sized target texture that keeps whatever was drawn into it until the window changes size or it is invalidated,
+         * so static parts of the UI only have to be drawn once and then cost a single copy per frame
+         * @param id Any non-negative number identifying the layer
+         * @returns Whether the layer has to be redrawn; if so, draw its contents as normal and then call endLayer()    */
+        bool beginLayer(const int &id);
+        /** Finish redrawing the layer started with beginLayer() and go back to drawing to the window */
+        void endLayer();
+        /** Composite a layer onto the window with one copy */
+        void renderLayer(const int &id);
+        /** Force a layer to be redrawn on its next beginLayer(), e.g. after the colors it was drawn with changed */
+        void invalidateLayer(const int &id);
+        void invalidateLayers();
+
+        /** Mark an area as needing to be repainted by the next repaint()
+         * Overlapping & touching areas are merged; past RENDER_DAMAGE_MAX_RECTS areas everything is merged into one
+         * @param x Left edge (in the same coordinates as fillRectangle())
+         * @param y Top edge
+         * @param w Width in pixels
+         * @param h Height in pixels    */
+        void damage(const int &x, const int &y, const int &w, const int &h);
+        void damageAll();
+        bool isDamaged() const;
+        /** Repaint the damaged areas and present the frame
+         * draw is called once per damaged area with drawing clipped to it, on top of a back buffer that keeps everything else from the previous frame,
+         * so it should draw the whole scene exactly like a full redraw would (clear() only clears the area being repainted)
+         * @param draw Draws the scene; may use any drawing function including layers, but must not call show()    */
+        void repaint(const std::function<void()> &draw);
+
+        /** Draw part of a heightmap at any zoom through its LOD pyramid & the grid ramp, clipped to dst
+         * The depth drawn is the coarsest one whose cells are no bigger than a pixel, so the cost follows the size of dst rather than the heightmap;
+         * the texture is only refilled when the visible cells or the value range change, and edits to the pyramid only refill the rows they touched
+         * @param pyramid Pyramid built from grid
+         * @param grid The heightmap
+         * @param row Heightmap row at the top edge of dst (may be fractional or outside the heightmap)
+         * @param col Heightmap column at the left edge of dst
+         * @param zoom Pixels per heightmap cell
+         * @param minVal Value drawn with the first color of the ramp
+         * @param maxVal Value drawn with the last color of the ramp
+         * @param dst Area to draw in (x & y are its top-left corner, in the same coordinates as fillRectangle())
+         * @param mode Value to show for cells covering several heightmap cells; either PYRAMID_MEAN, PYRAMID_MIN or PYRAMID_MAX    */
+        void renderHeightView(const HeightPyramid &pyramid, const std::vector<std::vector<double>> &grid, const double &row, const double &col, const double &zoom, const double &minVal, const double &maxVal, const SDL_Rect &dst, const unsigned char &mode = PYRAMID_MEAN);
+
+        /** Draw what a recorded search looked at on top of a heightmap drawn with renderHeightView()
+         * Cells are colored by when they were first expanded, from dark blue (first) to red (last); cells expanded more than once or reopened are white.
+         * Only the visible cells are built, one texel per block of cells when zoomed out (colored by the block's first expansion)
+         * @param recorder The recording to draw; only re-read when it starts a new search or records more events
+         * @param row Heightmap row at the top edge of dst
+         * @param col Heightmap column at the left edge of dst
+         * @param zoom Pixels per heightmap cell
+         * @param dst Area to draw in (x & y are its top-left corner, in the same coordinates as fillRectangle())
+         * @param opacity Opacity of the overlay    */
+        void renderSearchHeat(const AStar_Recorder &recorder, const double &row, const double &col, const double &zoom, const SDL_Rect &dst, const Uint8 &opacity = 160);
+
+        /** Tint the marked cells of a mask on top of a heightmap drawn with renderHeightView()
+         * Only the visible cells are uploaded (a cell per block of cells when zoomed out), and only when they, the mask or the color change
+         * @param mask One byte per heightmap cell in row-major order; cells that aren't 0 are tinted
+         * @param gridW Width of the heightmap in cells
+         * @param gridH Height of the heightmap in cells
+         * @param serial Number that changes whenever the contents of mask do
+         * @param row Heightmap row at the top edge of dst
+         * @param col Heightmap column at the left edge of dst
+         * @param zoom Pixels per heightmap cell
+         * @param dst Area to draw in (x & y are its top-left corner, in the same coordinates as fillRectangle())
+         * @param color Color of the tint, including its opacity    */
+        void renderCellMask(const std::vector<unsigned char> &mask, const int &gridW, const int &gridH, const unsigned long int &serial, const double &row, const double &col, const double &zoom, const SDL_Rect &dst, const SDL_Color &color);
+
+        /** Restrict drawing to an area (within whatever area repaint() is already restricted to)
+         * @param x Left edge (in the same coordinates as fillRectangle())
+         * @param y Top edge
+         * @param w Width in pixels
+         * @param h Height in pixels    */
+        void setClip(const int &x, const int &y, const int &w, const int &h);
+        void resetClip();
+
+        /** Draw a string centered on a point
+         * Glyphs are rasterised once per font into a shared atlas and the layout of every string is cached, so redrawing the same label is just a batched set of quads
+         * @param font The font to draw with
+         * @param text Null-terminated string to draw
+         * @param pos Position of the center of the text
+         * @param wrapWidth Width in pixels to word wrap at; 0 disables wrapping
+         * @param color The SDL_Color to tint the text with    */
         void renderText(TTF_Font *font, const char16_t* text, const SDL_Point &pos, const Uint32 wrapWidth = 0, const SDL_Color &color = PresetColors[COLOR_WHITE]);
+        /** Drop the glyph atlas & cached layouts for a font; call before closing the font */
+        void releaseFont(TTF_Font *font);
 };
 
 #endif /* RENDERWINDOW */
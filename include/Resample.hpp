@@ -0,0 +1,104 @@
+#ifndef RESAMPLE
+#define RESAMPLE
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "RowBands.hpp"
+
+/** Source cells & weights every output cell along one axis is made from, padded to the same number of taps per cell */
+struct ResampleTaps {
+    std::vector<int> First;
+    std::vector<double> Weights;
+    int Count = 0;
+
+    /** @param from Number of cells along the axis before resampling
+     * @param to Number of cells along the axis after; shrinking averages every source cell an output cell covers, growing interpolates between the two nearest centers    */
+    ResampleTaps(const int &from, const int &to) : First(to), Count(1) {
+        const double scale = (double)from / to;
+        if (to < from) {
+            Count = (int)std::ceil(scale) + 1;
+            Weights.assign((unsigned long int)to * Count, 0.0);
+            for (int i = 0; i < to; i++) {
+                const double start = i * scale, end = std::min((i + 1) * scale, (double)from);
+                First[i] = (int)start;
+                for (int k = First[i]; k < end && k - First[i] < Count; k++) {Weights[(unsigned long int)i * Count + k - First[i]] = (std::min(end, k + 1.0) - std::max(start, (double)k)) / scale;}
+            }
+            return;
+        }
+
+        Count = 2;
+        Weights.assign((unsigned long int)to * Count, 0.0);
+        for (int i = 0; i < to; i++) {
+            const double center = std::min(std::max((i + 0.5) * scale - 0.5, 0.0), from - 1.0);
+            First[i] = std::min((int)center, std::max(from - 2, 0));
+            const double t = center - First[i];
+            Weights[(unsigned long int)i * Count] = 1.0 - t;
+            Weights[(unsigned long int)i * Count + 1] = First[i] + 1 < from ? t : 0.0;
+        }
+    }
+
+    /** @returns Tap k of output cell i, made safe to read when it falls past the end of the source    */
+    int getIndex(const int &i, const int &k, const int &from) const {return std::min(First[i] + k, from - 1);}
+    double getWeight(const int &i, const int &k) const {return Weights[(unsigned long int)i * Count + k];}
+};
+
+/** Resample one output row: filter the source rows it covers down the columns into a scratch row, then across it
+ * @param i Output row
+ * @param row Where the w cells of the output row go    */
+inline void resampleRow(const std::vector<std::vector<double>> &grid, const ResampleTaps &rows, const ResampleTaps &cols, const int &i, const int &w, double* row) {
+    const int oldW = grid[0].size(), oldH = grid.size();
+
+    // Each worker keeps its own scratch row between calls
+    thread_local std::vector<double> blended;
+    blended.assign(oldW, 0.0);
+    for (int k = 0; k < rows.Count; k++) {
+        const double weight = rows.getWeight(i, k);
+        if (weight == 0.0) {continue;}
+        const double* src = grid[rows.getIndex(i, k, oldH)].data();
+        for (int j = 0; j < oldW; j++) {blended[j] += weight * src[j];}
+    }
+
+    for (int j = 0; j < w; j++) {
+        double value = 0.0;
+        for (int k = 0; k < cols.Count; k++) {value += cols.getWeight(j, k) * blended[cols.getIndex(j, k, oldW)];}
+        row[j] = value;
+    }
+}
+
+/** Resample a grid to new dimensions, averaging the cells covered when shrinking & bilinearly interpolating when growing (each axis on its own)
+ * Rows are spread over several threads and written straight into one contiguous buffer
+ * @param w Width of the new grid in cells
+ * @param h Height of the new grid in cells
+ * @param fill Value of every cell if the old grid is empty
+ * @param threads Number of worker threads; 0 uses every available core
+ * @returns The new grid in row-major order (cell [i][j] is at index i * w + j)    */
+inline std::vector<double> resampleBuffer(const std::vector<std::vector<double>> &grid, const int &w, const int &h, const double &fill = 0.0, const unsigned int &threads = 0) {
+    if (w <= 0 || h <= 0) {return {};}
+    std::vector<double> output((unsigned long int)w * h, fill);
+    if (grid.empty() || grid[0].empty()) {return output;}
+
+    const ResampleTaps rows(grid.size(), h), cols(grid[0].size(), w);
+    forEachRowBand(h, threads, [&](const int &i) {resampleRow(grid, rows, cols, i, w, output.data() + (unsigned long int)i * w);});
+
+    return output;
+}
+
+/** Resample a grid to new dimensions in place; see resampleBuffer()
+ * The old rows are moved aside (not copied) and every new row is filtered straight out of them, so the old & new grids are only ever in memory once each
+ * @param w Width of the new grid in cells
+ * @param h Height of the new grid in cells
+ * @param fill Value of every cell if the old grid is empty    */
+inline void resampleGrid(std::vector<std::vector<double>> &grid, const int &w, const int &h, const double &fill = 0.0, const unsigned int &threads = 0) {
+    std::vector<std::vector<double>> source;
+    source.swap(grid);
+    if (w <= 0 || h <= 0) {return;}
+    grid.assign(h, std::vector<double>(w, fill));
+    if (source.empty() || source[0].empty()) {return;}
+
+    const ResampleTaps rows(source.size(), h), cols(source[0].size(), w);
+    forEachRowBand(h, threads, [&](const int &i) {resampleRow(source, rows, cols, i, w, grid[i].data());});
+}
+
+#endif /* RESAMPLE */
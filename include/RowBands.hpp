@@ -0,0 +1,32 @@
+#ifndef ROWBANDS
+#define ROWBANDS
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+/** Run a row function over every row of a grid, handing rows out to several threads in bands
+ * @param h Number of rows
+ * @param threads Number of worker threads; 0 uses every available core
+ * @param fillRow Called once per row index, from whichever thread picked up the row's band    */
+template <typename RowFunction> inline void forEachRowBand(const int &h, unsigned int threads, const RowFunction &fillRow) {
+    const int band = 16;
+    if (threads == 0) {threads = std::max(1u, std::thread::hardware_concurrency());}
+    threads = std::min(threads, (unsigned int)((h + band - 1) / band));
+
+    std::atomic<int> nextRow(0);
+    const auto worker = [&]() {
+        for (int first = nextRow.fetch_add(band); first < h; first = nextRow.fetch_add(band)) {
+            const int last = std::min(first + band, h);
+            for (int i = first; i < last; i++) {fillRow(i);}
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned int i = 1; i < threads; i++) {pool.emplace_back(worker);}
+    worker();
+    for (unsigned long int i = 0; i < pool.size(); i++) {pool[i].join();}
+}
+
+#endif /* ROWBANDS */
@@ -3,13 +3,21 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
+#include <string>
+
+#include "TextureAtlas.hpp"
 
 class Texture {
     private:
         SDL_Texture* Source = NULL;
+        // Set when the texture is part of an atlas, which owns the SDL_Texture (Source is then NULL)
+        const TextureAtlas* Atlas = NULL;
         SDL_Point Center;
         SDL_Rect Frame;
         double Angle = 0;
+        // cos & sin of Angle, kept so sprites don't have to work them out every time they are drawn
+        double AngleCos = 1;
+        double AngleSin = 0;
         SDL_RendererFlip Flip = SDL_FLIP_NONE;
 
         SDL_BlendMode BlendMode = SDL_BLENDMODE_NONE;
@@ -20,12 +28,20 @@ class Texture {
         Texture(SDL_Texture* texture);
         Texture(SDL_Texture* texture, SDL_Point center, SDL_Rect frame);
         Texture(SDL_Texture* texture, SDL_Rect frame);
+        /** Refer to an image packed into an atlas; the atlas has to outlive the texture, and its blending is used instead of the texture's
+         * Color & opacity mods are applied per sprite, so textures sharing an atlas can still be tinted differently    */
+        Texture(const TextureAtlas &atlas, const std::string &name);
+        Texture(const TextureAtlas &atlas, const std::string &name, SDL_Point center);
         ~Texture() {SDL_DestroyTexture(Source);}
 
         SDL_Texture* getTexture() const;
+        /** @returns The atlas the texture is part of, or NULL if it has a texture of its own    */
+        const TextureAtlas* getAtlas() const;
         SDL_Point getCenter() const;
         SDL_Rect getFrame() const;
         double getAngle() const;
+        double getAngleCos() const;
+        double getAngleSin() const;
         SDL_RendererFlip getFlip() const;
         
         SDL_BlendMode getBlending() const;
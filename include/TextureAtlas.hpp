@@ -0,0 +1,50 @@
+#ifndef TEXTUREATLAS
+#define TEXTUREATLAS
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/** Several images packed into one texture so sprites cut from it can all be drawn with a single call
+ * Images are added by name, then packed once; Textures made from the atlas afterwards refer to their part of it    */
+class TextureAtlas {
+    private:
+        struct Image {
+            std::string Name;
+            SDL_Surface* Pixels = NULL;
+        };
+
+        // Kept after packing so the texture can be packed again, e.g. once the renderer has lost it
+        std::vector<Image> Images;
+        std::unordered_map<std::string, SDL_Rect> Frames;
+        SDL_Texture* Source = NULL;
+        int W = 0;
+        int H = 0;
+
+    public:
+        TextureAtlas() {}
+        ~TextureAtlas();
+
+        TextureAtlas(const TextureAtlas&) = delete;
+        TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+        /** Load an image to be packed by the next pack()
+         * @param name What the image is looked up by; adding a name again replaces it
+         * @returns Whether the image could be loaded    */
+        bool add(const std::string &name, const std::string &path);
+        /** Pack every added image into one texture, replacing any texture packed before
+         * Images are sorted by height & laid out in rows with a pixel of space around them, in the narrowest power of two square-ish texture that fits
+         * @returns Whether the texture was created    */
+        bool pack(SDL_Renderer* renderer);
+
+        SDL_Texture* getTexture() const;
+        int getW() const;
+        int getH() const;
+        bool has(const std::string &name) const;
+        /** @returns Where an image ended up in the texture, or an empty rect if there is no such image    */
+        SDL_Rect getFrame(const std::string &name) const;
+};
+
+#endif /* TEXTUREATLAS */
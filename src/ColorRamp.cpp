@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "ColorRamp.hpp"
+
+namespace {
+    struct RampStop {
+        double T;
+        Uint8 R, G, B;
+    };
+
+    const RampStop HypsometricStops[] = {
+        {0.00,  20,  45, 110},
+        {0.28,  60, 115, 185},
+        {0.32, 205, 195, 145},
+        {0.38,  95, 155,  75},
+        {0.58,  45, 105,  45},
+        {0.74, 125, 100,  75},
+        {0.88, 160, 155, 150},
+        {1.00, 250, 250, 250}
+    };
+
+    const RampStop HeatStops[] = {
+        {0.00,  20,  20, 120},
+        {0.30,   0, 170, 220},
+        {0.60, 240, 230,  40},
+        {1.00, 220,  20,  20}
+    };
+
+    // How steep a slope looks; heights are measured as a fraction of the value range per cell
+    const double SlopeRelief = 24.0;
+}
+
+ColorRamp::ColorRamp(const unsigned char &type) : Type(type) {
+    for (int i = 0; i < 256; i++) {
+        Uint8 r, g, b;
+        switch (Type) {
+            case RAMP_HYPSOMETRIC:
+            case RAMP_HEAT: {
+                const RampStop* stops = Type == RAMP_HEAT ? HeatStops : HypsometricStops;
+                const unsigned long int stopCount = Type == RAMP_HEAT ? sizeof(HeatStops) / sizeof(RampStop) : sizeof(HypsometricStops) / sizeof(RampStop);
+                const double t = i / 255.0;
+                unsigned long int s = 1;
+                while (s < stopCount - 1 && stops[s].T < t) {s++;}
+                const RampStop &a = stops[s - 1], &c = stops[s];
+                const double f = (t - a.T) / (c.T - a.T);
+                r = a.R + (c.R - a.R) * f;
+                g = a.G + (c.G - a.G) * f;
+                b = a.B + (c.B - a.B) * f;
+                break;
+            }
+            case RAMP_SLOPE:
+                // Narrower than plain greyscale so the lighting has room either way
+                r = g = b = 220 - i * 150 / 255;
+                break;
+            default:
+                r = g = b = 255 - i;
+                break;
+        }
+        Table[i] = 0xFF000000 | (Uint32)r << 16 | (Uint32)g << 8 | (Uint32)b;
+    }
+}
+
+unsigned char ColorRamp::getType() const {return Type;}
+bool ColorRamp::isShaded() const {return Type == RAMP_SLOPE;}
+Uint32 ColorRamp::getColor(const unsigned char &index) const {return Table[index];}
+
+void ColorRamp::lookup(const double* heights, const int &count, const double &minVal, const double &maxVal, Uint32* pixels) const {
+    const double scale = maxVal > minVal ? 255.0 / (maxVal - minVal) : 0.0;
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128d low = _mm_set1_pd(minVal), factor = _mm_set1_pd(scale), zero = _mm_setzero_pd(), top = _mm_set1_pd(255.0);
+    for (; i + 4 <= count; i += 4) {
+        // max() returns its second operand for NaN, so NaN heights land on the first color like in the scalar loop
+        const __m128d a = _mm_min_pd(_mm_max_pd(_mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(heights + i), low), factor), zero), top);
+        const __m128d b = _mm_min_pd(_mm_max_pd(_mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(heights + i + 2), low), factor), zero), top);
+        const __m128i index = _mm_unpacklo_epi64(_mm_cvttpd_epi32(a), _mm_cvttpd_epi32(b));
+        // SSE2 has no gather, so the four lookups come straight out of the register
+        pixels[i] = Table[_mm_cvtsi128_si32(index)];
+        pixels[i + 1] = Table[_mm_cvtsi128_si32(_mm_srli_si128(index, 4))];
+        pixels[i + 2] = Table[_mm_cvtsi128_si32(_mm_srli_si128(index, 8))];
+        pixels[i + 3] = Table[_mm_cvtsi128_si32(_mm_srli_si128(index, 12))];
+    }
+#endif
+    for (; i < count; i++) {
+        const double t = (heights[i] - minVal) * scale;
+        pixels[i] = Table[!(t > 0.0) ? 0 : t >= 255.0 ? 255 : (int)t];
+    }
+}
+void ColorRamp::lookup(const float* heights, const int &count, const double &minVal, const double &maxVal, Uint32* pixels) const {
+    const float scale = maxVal > minVal ? 255.0 / (maxVal - minVal) : 0.0, low = minVal;
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 lows = _mm_set1_ps(low), factor = _mm_set1_ps(scale), zero = _mm_setzero_ps(), top = _mm_set1_ps(255.0f);
+    for (; i + 4 <= count; i += 4) {
+        const __m128i index = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(heights + i), lows), factor), zero), top));
+        pixels[i] = Table[_mm_cvtsi128_si32(index)];
+        pixels[i + 1] = Table[_mm_cvtsi128_si32(_mm_srli_si128(index, 4))];
+        pixels[i + 2] = Table[_mm_cvtsi128_si32(_mm_srli_si128(index, 8))];
+        pixels[i + 3] = Table[_mm_cvtsi128_si32(_mm_srli_si128(index, 12))];
+    }
+#endif
+    for (; i < count; i++) {
+        const float t = (heights[i] - low) * scale;
+        pixels[i] = Table[!(t > 0.0f) ? 0 : t >= 255.0f ? 255 : (int)t];
+    }
+}
+
+template <typename Height> void ColorRamp::shade(const Height* above, const Height* row, const Height* below, const int &count, const double &minVal, const double &maxVal, Uint32* pixels) const {
+    const double relief = maxVal > minVal ? SlopeRelief / (maxVal - minVal) : 0.0;
+    // Lambert lighting from the top-left; a flat cell keeps its ramp color
+    const double light = 1.0 / std::sqrt(3.0);
+    for (int j = 0; j < count; j++) {
+        const double dx = (row[std::min(j + 1, count - 1)] - row[std::max(j - 1, 0)]) * relief, dy = (below[j] - above[j]) * relief;
+        const double lambert = (dx + dy + 2.0) * light / std::sqrt(dx * dx + dy * dy + 4.0);
+        const double factor = std::isnan(lambert) ? 1.0 : std::min(std::max(lambert / light, 0.2), 1.6);
+
+        const Uint32 color = pixels[j];
+        const Uint32 r = std::min(((color >> 16) & 0xFF) * factor, 255.0), g = std::min(((color >> 8) & 0xFF) * factor, 255.0), b = std::min((color & 0xFF) * factor, 255.0);
+        pixels[j] = 0xFF000000 | r << 16 | g << 8 | b;
+    }
+}
+
+template <typename Height> void ColorRamp::convertRow(const Height* above, const Height* row, const Height* below, const int &count, const double &minVal, const double &maxVal, Uint32* pixels) const {
+    lookup(row, count, minVal, maxVal, pixels);
+    if (isShaded()) {shade(above != NULL ? above : row, row, below != NULL ? below : row, count, minVal, maxVal, pixels);}
+}
+
+void ColorRamp::convert(const double* above, const double* row, const double* below, const int &count, const double &minVal, const double &maxVal, Uint32* pixels) const {convertRow(above, row, below, count, minVal, maxVal, pixels);}
+void ColorRamp::convert(const float* above, const float* row, const float* below, const int &count, const double &minVal, const double &maxVal, Uint32* pixels) const {convertRow(above, row, below, count, minVal, maxVal, pixels);}
@@ -0,0 +1,166 @@
+#include <iostream>
+#include <algorithm>
+
+#include "GlyphAtlas.hpp"
+
+GlyphAtlas::GlyphAtlas(SDL_Renderer* renderer, TTF_Font* font, const int &size) : Renderer(renderer), Font(font) {
+    if ((Pixels = SDL_CreateRGBSurfaceWithFormat(0, size, size, 32, SDL_PIXELFORMAT_ARGB8888)) == NULL) {std::cout << "Failed to create glyph atlas\nERROR: " << SDL_GetError() << "\n";}
+    else {
+        SDL_FillRect(Pixels, NULL, 0);
+        if ((Source = SDL_CreateTextureFromSurface(Renderer, Pixels)) == NULL) {std::cout << "Failed to create glyph atlas texture\nERROR: " << SDL_GetError() << "\n";}
+        SDL_SetTextureBlendMode(Source, SDL_BLENDMODE_BLEND);
+    }
+}
+GlyphAtlas::~GlyphAtlas() {
+    releaseRetired();
+    SDL_DestroyTexture(Source);
+    SDL_FreeSurface(Pixels);
+}
+
+SDL_Texture* GlyphAtlas::getTexture() const {return Source;}
+void GlyphAtlas::releaseRetired() {
+    for (unsigned long int i = 0; i < Retired.size(); i++) {SDL_DestroyTexture(Retired[i]);}
+    Retired.clear();
+}
+
+bool GlyphAtlas::grow() {
+    SDL_Surface* pixels = SDL_CreateRGBSurfaceWithFormat(0, Pixels->w, Pixels->h * 2, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (pixels == NULL) {
+        std::cout << "Failed to grow glyph atlas\nERROR: " << SDL_GetError() << "\n";
+        return false;
+    }
+    SDL_FillRect(pixels, NULL, 0);
+    SDL_SetSurfaceBlendMode(Pixels, SDL_BLENDMODE_NONE);
+    SDL_BlitSurface(Pixels, NULL, pixels, NULL);
+
+    SDL_Texture* source = SDL_CreateTextureFromSurface(Renderer, pixels);
+    if (source == NULL) {
+        std::cout << "Failed to grow glyph atlas texture\nERROR: " << SDL_GetError() << "\n";
+        SDL_FreeSurface(pixels);
+        return false;
+    }
+    SDL_SetTextureBlendMode(source, SDL_BLENDMODE_BLEND);
+
+    SDL_FreeSurface(Pixels);
+    Retired.push_back(Source);
+    Pixels = pixels;
+    Source = source;
+    Layouts.clear();
+    return true;
+}
+
+const GlyphAtlas::Glyph* GlyphAtlas::getGlyph(const Uint16 &ch) {
+    const std::unordered_map<Uint16, Glyph>::const_iterator found = Glyphs.find(ch);
+    if (found != Glyphs.end()) {return &found->second;}
+    if (Pixels == NULL || Source == NULL) {return NULL;}
+
+    int minX, maxX, minY, maxY, advance;
+    if (TTF_GlyphMetrics(Font, ch, &minX, &maxX, &minY, &maxY, &advance) != 0) {return NULL;}
+
+    Glyph glyph;
+    glyph.Advance = advance;
+    SDL_Surface* surface = TTF_RenderGlyph_Blended(Font, ch, {255, 255, 255, 255});
+    if (surface != NULL) {
+        if (surface->w > Pixels->w) {
+            SDL_FreeSurface(surface);
+            return NULL;
+        }
+        if (PenX + surface->w > Pixels->w) {
+            PenX = 0;
+            PenY += RowH + 1;
+            RowH = 0;
+        }
+        while (PenY + surface->h > Pixels->h) {
+            if (!grow()) {
+                SDL_FreeSurface(surface);
+                return NULL;
+            }
+        }
+
+        glyph.Frame = {PenX, PenY, surface->w, surface->h};
+        SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+        SDL_BlitSurface(surface, NULL, Pixels, &glyph.Frame);
+        SDL_FreeSurface(surface);
+
+        const Uint8* pixels = (const Uint8*)Pixels->pixels + glyph.Frame.y * Pixels->pitch + glyph.Frame.x * 4;
+        SDL_UpdateTexture(Source, &glyph.Frame, pixels, Pixels->pitch);
+
+        PenX += glyph.Frame.w + 1;
+        RowH = std::max(RowH, glyph.Frame.h);
+    }
+
+    return &(Glyphs[ch] = glyph);
+}
+
+const GlyphAtlas::Layout& GlyphAtlas::layout(const char16_t* text, const Uint32 &wrapWidth) {
+    std::u16string key(text);
+    key.push_back(u'\0');
+    key.push_back((char16_t)(wrapWidth & 0xFFFF));
+    key.push_back((char16_t)(wrapWidth >> 16));
+
+    const std::unordered_map<std::u16string, Layout>::const_iterator found = Layouts.find(key);
+    if (found != Layouts.end()) {return found->second;}
+
+    // Rasterise everything first, since growing the atlas moves every glyph's texture coordinates
+    for (const char16_t* c = text; *c != u'\0'; c++) {
+        if (*c != u'\n') {getGlyph(*c);}
+    }
+
+    Layout output;
+    const float texW = Pixels != NULL ? Pixels->w : 1, texH = Pixels != NULL ? Pixels->h : 1;
+    const int lineSkip = TTF_FontLineSkip(Font), height = TTF_FontHeight(Font);
+    int x = 0, y = 0;
+
+    const char16_t* c = text;
+    while (*c != u'\0') {
+        if (*c == u'\n') {
+            x = 0;
+            y += lineSkip;
+            c++;
+            continue;
+        }
+
+        // Measure the next word (and the space in front of it) to decide whether it needs to go on a new line
+        const char16_t* wordEnd = c;
+        int wordW = 0;
+        while (*wordEnd == u' ') {
+            const Glyph* glyph = getGlyph(*wordEnd);
+            wordW += glyph != NULL ? glyph->Advance : 0;
+            wordEnd++;
+        }
+        while (*wordEnd != u'\0' && *wordEnd != u' ' && *wordEnd != u'\n') {
+            const Glyph* glyph = getGlyph(*wordEnd);
+            wordW += glyph != NULL ? glyph->Advance : 0;
+            wordEnd++;
+        }
+        if (wrapWidth > 0 && x > 0 && x + wordW > (int)wrapWidth) {
+            // The spaces the line breaks at are dropped
+            x = 0;
+            y += lineSkip;
+            while (*c == u' ') {c++;}
+        }
+
+        for (; c != wordEnd; c++) {
+            const Glyph* glyph = getGlyph(*c);
+            if (glyph == NULL) {continue;}
+            if (glyph->Frame.w > 0 && glyph->Frame.h > 0) {
+                const int first = output.Vertices.size();
+                const float x1 = x, y1 = y, x2 = x + glyph->Frame.w, y2 = y + glyph->Frame.h;
+                const float u1 = glyph->Frame.x / texW, v1 = glyph->Frame.y / texH, u2 = (glyph->Frame.x + glyph->Frame.w) / texW, v2 = (glyph->Frame.y + glyph->Frame.h) / texH;
+                output.Vertices.push_back({{x1, y1}, {255, 255, 255, 255}, {u1, v1}});
+                output.Vertices.push_back({{x2, y1}, {255, 255, 255, 255}, {u2, v1}});
+                output.Vertices.push_back({{x2, y2}, {255, 255, 255, 255}, {u2, v2}});
+                output.Vertices.push_back({{x1, y2}, {255, 255, 255, 255}, {u1, v2}});
+                const int indices[6] = {first, first + 1, first + 2, first, first + 2, first + 3};
+                output.Indices.insert(output.Indices.end(), indices, indices + 6);
+            }
+            x += glyph->Advance;
+            output.W = std::max(output.W, x);
+        }
+    }
+    output.H = y + height;
+
+    // Labels that change every frame would otherwise pile up forever
+    if (Layouts.size() >= 1024) {Layouts.clear();}
+    return Layouts[key] = std::move(output);
+}
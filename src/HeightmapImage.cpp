@@ -0,0 +1,219 @@
+#include <iostream>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cctype>
+#include <cmath>
+#include <algorithm>
+#include <png.h>
+
+#include "HeightmapImage.hpp"
+
+namespace {
+    // Largest width & height accepted from a file
+    const unsigned long int MaxSide = 1 << 16;
+
+    std::uint16_t quantize(const double &value, const double &minVal, const double &range) {return range > 0.0 ? (std::uint16_t)std::lround(std::min(std::max((value - minVal) / range, 0.0), 1.0) * 65535.0) : 0;}
+
+    /** Read the next number of a PGM header, skipping whitespace & comments
+     * @returns Whether there was a number    */
+    bool readPGMNumber(std::FILE* file, unsigned long int &output) {
+        int c = std::fgetc(file);
+        while (c != EOF && (std::isspace(c) || c == '#')) {
+            if (c == '#') {
+                while (c != EOF && c != '\n') {c = std::fgetc(file);}
+            }
+            c = std::fgetc(file);
+        }
+        if (c == EOF || !std::isdigit(c)) {return false;}
+
+        output = 0;
+        while (c != EOF && std::isdigit(c)) {
+            output = std::min(output * 10 + (c - '0'), 0xFFFFFFFFul);
+            c = std::fgetc(file);
+        }
+        // Exactly one whitespace character ends the header's last number, and it has just been read
+        return c != EOF && std::isspace(c);
+    }
+
+    bool importPGM(std::FILE* file, std::vector<std::vector<double>> &grid, const double &minVal, const double &maxVal) {
+        unsigned long int w, h, maxSample;
+        if (!readPGMNumber(file, w) || !readPGMNumber(file, h) || !readPGMNumber(file, maxSample) || w == 0 || h == 0 || w > MaxSide || h > MaxSide || maxSample == 0 || maxSample > 65535) {
+            std::cout << "Failed to import heightmap\nERROR: Invalid PGM header\n";
+            return false;
+        }
+
+        // Samples past 255 take two bytes, most significant first
+        const unsigned long int bytes = maxSample > 255 ? 2 : 1;
+        const double scale = (maxVal - minVal) / maxSample;
+        std::vector<unsigned char> row(w * bytes);
+        grid.resize(h);
+        for (unsigned long int i = 0; i < h; i++) {
+            grid[i].resize(w);
+            if (std::fread(row.data(), row.size(), 1, file) != 1) {
+                std::cout << "Failed to import heightmap\nERROR: PGM is cut short at row " << i << "\n";
+                return false;
+            }
+            for (unsigned long int j = 0; j < w; j++) {
+                const unsigned long int sample = bytes == 2 ? (unsigned long int)row[j * 2] << 8 | row[j * 2 + 1] : row[j];
+                grid[i][j] = minVal + std::min(sample, maxSample) * scale;
+            }
+        }
+        return true;
+    }
+
+    bool importPNG(std::FILE* file, std::vector<std::vector<double>> &grid, const double &minVal, const double &maxVal) {
+        png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+        png_infop info = png != NULL ? png_create_info_struct(png) : NULL;
+        if (info == NULL) {
+            png_destroy_read_struct(&png, NULL, NULL);
+            std::cout << "Failed to import heightmap\nERROR: Could not start PNG decoder\n";
+            return false;
+        }
+
+        // Declared before setjmp() so it is still intact if libpng jumps back
+        std::vector<png_byte> row;
+        if (setjmp(png_jmpbuf(png))) {
+            png_destroy_read_struct(&png, &info, NULL);
+            std::cout << "Failed to import heightmap\nERROR: PNG is damaged\n";
+            return false;
+        }
+
+        png_init_io(png, file);
+        png_read_info(png, info);
+        const unsigned long int w = png_get_image_width(png, info), h = png_get_image_height(png, info);
+        const int colorType = png_get_color_type(png, info);
+        if (w == 0 || h == 0 || w > MaxSide || h > MaxSide || png_get_interlace_type(png, info) != PNG_INTERLACE_NONE) {
+            png_destroy_read_struct(&png, &info, NULL);
+            std::cout << "Failed to import heightmap\nERROR: PNG is too large or interlaced\n";
+            return false;
+        }
+
+        // Whatever the image is stored as, rows come out as one grey sample per pixel
+        if (colorType == PNG_COLOR_TYPE_PALETTE) {png_set_palette_to_rgb(png);}
+        if (colorType == PNG_COLOR_TYPE_GRAY && png_get_bit_depth(png, info) < 8) {png_set_expand_gray_1_2_4_to_8(png);}
+        // A tRNS chunk is turned into an alpha channel by the expansions above, so it is dropped along with any stored alpha
+        if (png_get_valid(png, info, PNG_INFO_tRNS)) {png_set_tRNS_to_alpha(png);}
+        if ((colorType & PNG_COLOR_MASK_ALPHA) || png_get_valid(png, info, PNG_INFO_tRNS)) {png_set_strip_alpha(png);}
+        if (colorType & PNG_COLOR_MASK_COLOR) {png_set_rgb_to_gray_fixed(png, 1, -1, -1);}
+        png_read_update_info(png, info);
+        if (png_get_channels(png, info) != 1 || (png_get_bit_depth(png, info) != 8 && png_get_bit_depth(png, info) != 16)) {
+            png_destroy_read_struct(&png, &info, NULL);
+            std::cout << "Failed to import heightmap\nERROR: PNG could not be converted to greyscale\n";
+            return false;
+        }
+
+        // 16-bit samples come out most significant byte first
+        const unsigned long int bytes = png_get_bit_depth(png, info) == 16 ? 2 : 1;
+        const double scale = (maxVal - minVal) / (bytes == 2 ? 65535.0 : 255.0);
+        row.resize(png_get_rowbytes(png, info));
+        grid.resize(h);
+        for (unsigned long int i = 0; i < h; i++) {
+            grid[i].resize(w);
+            png_read_row(png, row.data(), NULL);
+            double* cells = grid[i].data();
+            for (unsigned long int j = 0; j < w; j++) {cells[j] = minVal + (bytes == 2 ? (unsigned long int)row[j * 2] << 8 | row[j * 2 + 1] : row[j]) * scale;}
+        }
+        png_read_end(png, NULL);
+        png_destroy_read_struct(&png, &info, NULL);
+        return true;
+    }
+
+    bool exportPGM(std::FILE* file, const std::vector<std::vector<double>> &grid, const double &minVal, const double &maxVal) {
+        const unsigned long int w = grid[0].size();
+        bool written = std::fprintf(file, "P5\n%lu %lu\n65535\n", w, (unsigned long int)grid.size()) > 0;
+
+        std::vector<unsigned char> row(w * 2);
+        for (unsigned long int i = 0; i < grid.size() && written; i++) {
+            for (unsigned long int j = 0; j < w; j++) {
+                const std::uint16_t sample = quantize(grid[i][j], minVal, maxVal - minVal);
+                row[j * 2] = sample >> 8;
+                row[j * 2 + 1] = sample & 0xFF;
+            }
+            written = std::fwrite(row.data(), row.size(), 1, file) == 1;
+        }
+        return written;
+    }
+
+    bool exportPNG(std::FILE* file, const std::vector<std::vector<double>> &grid, const double &minVal, const double &maxVal) {
+        png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+        png_infop info = png != NULL ? png_create_info_struct(png) : NULL;
+        if (info == NULL) {
+            png_destroy_write_struct(&png, NULL);
+            return false;
+        }
+
+        const unsigned long int w = grid[0].size();
+        std::vector<png_byte> row(w * 2);
+        if (setjmp(png_jmpbuf(png))) {
+            png_destroy_write_struct(&png, &info);
+            return false;
+        }
+
+        png_init_io(png, file);
+        // Heightmaps are large & compress well enough at a low level, which is several times faster than the default
+        png_set_compression_level(png, 3);
+        png_set_IHDR(png, info, w, grid.size(), 16, PNG_COLOR_TYPE_GRAY, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+        png_write_info(png, info);
+        for (unsigned long int i = 0; i < grid.size(); i++) {
+            for (unsigned long int j = 0; j < w; j++) {
+                const std::uint16_t sample = quantize(grid[i][j], minVal, maxVal - minVal);
+                row[j * 2] = sample >> 8;
+                row[j * 2 + 1] = sample & 0xFF;
+            }
+            png_write_row(png, row.data());
+        }
+        png_write_end(png, NULL);
+        png_destroy_write_struct(&png, &info);
+        return true;
+    }
+}
+
+bool isHeightmapImage(const std::string &path) {
+    if (path.size() < 4) {return false;}
+    std::string extension = path.substr(path.size() - 4);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](const char &c) {return (char)std::tolower(c);});
+    return extension == ".png" || extension == ".pgm";
+}
+
+bool importHeightmap(const std::string &path, std::vector<std::vector<double>> &grid, const double &minVal, const double &maxVal) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == NULL) {
+        std::cout << "Failed to open heightmap\nERROR: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    // Decoded into a grid of its own and only swapped in once complete, so a failed import leaves the grid as it was
+    std::vector<std::vector<double>> image;
+    unsigned char signature[8] = {0};
+    const unsigned long int count = std::fread(signature, 1, sizeof(signature), file);
+    bool output = false;
+    if (count == sizeof(signature) && png_sig_cmp(signature, 0, sizeof(signature)) == 0) {
+        std::rewind(file);
+        output = importPNG(file, image, minVal, maxVal);
+    } else if (count >= 2 && signature[0] == 'P' && signature[1] == '5') {
+        std::fseek(file, 2, SEEK_SET);
+        output = importPGM(file, image, minVal, maxVal);
+    } else {std::cout << "Failed to import heightmap\nERROR: Not a PNG or binary PGM\n";}
+
+    std::fclose(file);
+    if (output) {grid.swap(image);}
+    return output;
+}
+
+bool exportHeightmap(const std::string &path, const std::vector<std::vector<double>> &grid, const double &minVal, const double &maxVal) {
+    if (grid.empty() || grid[0].empty()) {return false;}
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == NULL) {
+        std::cout << "Failed to export heightmap\nERROR: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    std::string extension = path.size() >= 4 ? path.substr(path.size() - 4) : "";
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](const char &c) {return (char)std::tolower(c);});
+    bool written = extension == ".pgm" ? exportPGM(file, grid, minVal, maxVal) : exportPNG(file, grid, minVal, maxVal);
+    written = std::fclose(file) == 0 && written;
+    if (!written) {std::cout << "Failed to export heightmap\nERROR: Could not write " << path << "\n";}
+    return written;
+}
@@ -0,0 +1,303 @@
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <algorithm>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "MapFile.hpp"
+#include "RowBands.hpp"
+
+namespace {
+    const char Magic[8] = {'T', 'B', 'L', 'Z', 'M', 'A', 'P', '\0'};
+    // Largest width & height accepted, which keeps every offset well inside 64 bits
+    const std::uint32_t MaxCells = 1 << 20;
+
+    static_assert(sizeof(MapFile::Header) == 64, "Map file headers must be 64 bytes");
+
+    std::uint32_t crc32(const unsigned char* data, const std::uint64_t &size) {
+        static std::uint32_t table[256] = {0};
+        if (table[1] == 0) {
+            for (std::uint32_t i = 0; i < 256; i++) {
+                std::uint32_t value = i;
+                for (int j = 0; j < 8; j++) {value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;}
+                table[i] = value;
+            }
+        }
+
+        std::uint32_t output = 0xFFFFFFFFu;
+        for (std::uint64_t i = 0; i < size; i++) {output = table[(output ^ data[i]) & 0xFF] ^ (output >> 8);}
+        return output ^ 0xFFFFFFFFu;
+    }
+
+    unsigned long int valueBytes(const std::uint32_t &type) {return type == MAPFILE_UINT16 ? sizeof(std::uint16_t) : sizeof(float);}
+
+    // Files are little-endian, so big-endian hosts swap every value on the way in & out
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    const bool BigEndian = true;
+#else
+    const bool BigEndian = false;
+#endif
+
+    /** Convert a value between the host's byte order & little-endian (the same swap goes both ways) */
+    template <typename T> T littleEndian(const T &value) {
+        if (!BigEndian) {return value;}
+        unsigned char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        std::reverse(bytes, bytes + sizeof(T));
+        T output;
+        std::memcpy(&output, bytes, sizeof(T));
+        return output;
+    }
+    void littleEndian(MapFile::Header &header) {
+        header.Version = littleEndian(header.Version);
+        header.W = littleEndian(header.W);
+        header.H = littleEndian(header.H);
+        header.TileSize = littleEndian(header.TileSize);
+        header.Type = littleEndian(header.Type);
+        header.Flags = littleEndian(header.Flags);
+        header.MinVal = littleEndian(header.MinVal);
+        header.MaxVal = littleEndian(header.MaxVal);
+        header.ChecksumOffset = littleEndian(header.ChecksumOffset);
+        header.DataOffset = littleEndian(header.DataOffset);
+    }
+}
+
+MapFile::~MapFile() {close();}
+
+bool MapFile::open(const std::string &path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cout << "Failed to open map file\nERROR: Windows error " << GetLastError() << "\n";
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        std::cout << "Failed to read map file size\nERROR: Windows error " << GetLastError() << "\n";
+        CloseHandle(file);
+        return false;
+    }
+    // Empty files can't be mapped, & wouldn't leave an error code saying why
+    if (size.QuadPart == 0) {
+        std::cout << "Failed to read map file\nERROR: File is empty\n";
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    const void* view = mapping != NULL ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (view == NULL) {
+        std::cout << "Failed to map map file\nERROR: Windows error " << GetLastError() << "\n";
+        if (mapping != NULL) {CloseHandle(mapping);}
+        CloseHandle(file);
+        return false;
+    }
+    File = file;
+    Mapping = mapping;
+    Size = size.QuadPart;
+#else
+    const int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        std::cout << "Failed to open map file\nERROR: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    struct stat status;
+    if (fstat(file, &status) != 0) {
+        std::cout << "Failed to read map file size\nERROR: " << std::strerror(errno) << "\n";
+        ::close(file);
+        return false;
+    }
+    // Empty files can't be mapped, & wouldn't leave an error code saying why
+    if (status.st_size == 0) {
+        std::cout << "Failed to read map file\nERROR: File is empty\n";
+        ::close(file);
+        return false;
+    }
+    void* view = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, file, 0);
+    const int mapError = errno;
+    // The mapping stays valid once the file is closed
+    ::close(file);
+    if (view == MAP_FAILED) {
+        std::cout << "Failed to map map file\nERROR: " << std::strerror(mapError) << "\n";
+        return false;
+    }
+    Size = status.st_size;
+#endif
+    Data = (const unsigned char*)view;
+
+    std::string error;
+    if (Size < sizeof(Header)) {error = "File is too small to be a map";}
+    else {
+        std::memcpy(&Info, Data, sizeof(Header));
+        littleEndian(Info);
+        const std::uint64_t tiles = Info.TileSize > 0 ? (std::uint64_t)getTilesW() * getTilesH() : 0;
+        if (std::memcmp(Info.Magic, Magic, sizeof(Magic)) != 0) {error = "Not a map file";}
+        else if (Info.Version != MAPFILE_VERSION) {error = "Unsupported map file version " + std::to_string(Info.Version);}
+        else if (Info.Type != MAPFILE_FLOAT32 && Info.Type != MAPFILE_UINT16) {error = "Unknown value type " + std::to_string(Info.Type);}
+        else if (Info.W == 0 || Info.H == 0 || Info.W > MaxCells || Info.H > MaxCells || Info.TileSize == 0 || Info.TileSize > 4096) {error = "Invalid map dimensions";}
+        else if (Info.DataOffset % valueBytes(Info.Type) != 0 || Info.DataOffset > Size || tiles * getTileBytes() > Size - Info.DataOffset) {error = "Map file is truncated";}
+        else if ((Info.Flags & MAPFILE_CHECKSUMS) && (Info.ChecksumOffset % sizeof(std::uint32_t) != 0 || Info.ChecksumOffset > Size || tiles * sizeof(std::uint32_t) > Size - Info.ChecksumOffset)) {error = "Map file checksums are truncated";}
+    }
+    if (!error.empty()) {
+        std::cout << "Failed to read map file\nERROR: " << error << "\n";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MapFile::close() {
+    if (Data == NULL) {return;}
+#ifdef _WIN32
+    UnmapViewOfFile(Data);
+    CloseHandle(Mapping);
+    CloseHandle(File);
+    Mapping = NULL;
+    File = NULL;
+#else
+    munmap((void*)Data, Size);
+#endif
+    Data = NULL;
+    Size = 0;
+}
+
+bool MapFile::isOpen() const {return Data != NULL;}
+
+const MapFile::Header& MapFile::getHeader() const {return Info;}
+int MapFile::getW() const {return Info.W;}
+int MapFile::getH() const {return Info.H;}
+int MapFile::getTilesW() const {return (Info.W + Info.TileSize - 1) / Info.TileSize;}
+int MapFile::getTilesH() const {return (Info.H + Info.TileSize - 1) / Info.TileSize;}
+std::uint64_t MapFile::getTileBytes() const {return (std::uint64_t)Info.TileSize * Info.TileSize * valueBytes(Info.Type);}
+
+const void* MapFile::getTile(const int &tileRow, const int &tileCol) const {return Data + Info.DataOffset + ((std::uint64_t)tileRow * getTilesW() + tileCol) * getTileBytes();}
+
+double MapFile::get(const int &row, const int &col) const {
+    const unsigned long int cell = (unsigned long int)(row % Info.TileSize) * Info.TileSize + col % Info.TileSize;
+    const void* tile = getTile(row / Info.TileSize, col / Info.TileSize);
+    if (Info.Type == MAPFILE_UINT16) {return Info.MinVal + littleEndian(((const std::uint16_t*)tile)[cell]) * ((Info.MaxVal - Info.MinVal) / 65535.0);}
+    return littleEndian(((const float*)tile)[cell]);
+}
+
+bool MapFile::verify() const {
+    if (!(Info.Flags & MAPFILE_CHECKSUMS)) {return true;}
+    const std::uint32_t* stored = (const std::uint32_t*)(Data + Info.ChecksumOffset);
+    for (int i = 0; i < getTilesH(); i++) {
+        for (int j = 0; j < getTilesW(); j++) {
+            if (crc32((const unsigned char*)getTile(i, j), getTileBytes()) != littleEndian(stored[(unsigned long int)i * getTilesW() + j])) {
+                std::cout << "Failed to verify map file\nERROR: Tile " << i << ", " << j << " does not match its checksum\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void MapFile::read(std::vector<std::vector<double>> &grid, const unsigned int &threads) const {
+    grid.resize(Info.H);
+    const int tileSize = Info.TileSize;
+    const double scale = (Info.MaxVal - Info.MinVal) / 65535.0;
+
+    forEachRowBand(Info.H, threads, [&](const int &i) {
+        std::vector<double> &row = grid[i];
+        row.resize(Info.W);
+        for (int tile = 0; tile < getTilesW(); tile++) {
+            const int first = tile * tileSize, count = std::min(tileSize, (int)Info.W - first);
+            const unsigned long int offset = (unsigned long int)(i % tileSize) * tileSize;
+            if (Info.Type == MAPFILE_UINT16) {
+                const std::uint16_t* src = (const std::uint16_t*)getTile(i / tileSize, tile) + offset;
+                for (int j = 0; j < count; j++) {row[first + j] = Info.MinVal + littleEndian(src[j]) * scale;}
+            } else {
+                const float* src = (const float*)getTile(i / tileSize, tile) + offset;
+                for (int j = 0; j < count; j++) {row[first + j] = littleEndian(src[j]);}
+            }
+        }
+    });
+}
+
+bool MapFile::save(const std::string &path, const std::vector<std::vector<double>> &grid, const unsigned char &type, const double &minVal, const double &maxVal, const bool &checksums, const int &tileSize) {
+    if (grid.empty() || grid[0].empty() || tileSize <= 0 || (type != MAPFILE_FLOAT32 && type != MAPFILE_UINT16)) {
+        std::cout << "Failed to save map file\nERROR: Nothing to save\n";
+        return false;
+    }
+
+    Header header;
+    std::memcpy(header.Magic, Magic, sizeof(Magic));
+    header.Version = MAPFILE_VERSION;
+    header.W = grid[0].size();
+    header.H = grid.size();
+    header.TileSize = tileSize;
+    header.Type = type;
+    header.Flags = checksums ? MAPFILE_CHECKSUMS : 0;
+    header.MinVal = minVal;
+    header.MaxVal = maxVal;
+    const int tilesW = (header.W + tileSize - 1) / tileSize, tilesH = (header.H + tileSize - 1) / tileSize;
+    header.ChecksumOffset = checksums ? sizeof(Header) : 0;
+    header.DataOffset = (sizeof(Header) + (checksums ? (std::uint64_t)tilesW * tilesH * sizeof(std::uint32_t) : 0) + MAPFILE_ALIGN - 1) / MAPFILE_ALIGN * MAPFILE_ALIGN;
+
+    // The map is written next to the target & moved over it once complete, so a failed save never leaves a half-written map behind
+    const std::string temp = path + ".tmp";
+    FILE* file = std::fopen(temp.c_str(), "wb");
+    if (file == NULL) {
+        std::cout << "Failed to save map file\nERROR: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    // The checksums are only known once the tiles are encoded, so the space before the tiles is written as zeros first & filled in last
+    std::vector<unsigned char> padding(header.DataOffset - sizeof(Header), 0);
+    Header stored = header;
+    littleEndian(stored);
+    bool written = std::fwrite(&stored, sizeof(Header), 1, file) == 1 && (padding.empty() || std::fwrite(padding.data(), padding.size(), 1, file) == 1);
+
+    const unsigned long int cells = (unsigned long int)tileSize * tileSize;
+    std::vector<float> floats(type == MAPFILE_FLOAT32 ? cells : 0);
+    std::vector<std::uint16_t> shorts(type == MAPFILE_UINT16 ? cells : 0);
+    std::vector<std::uint32_t> sums;
+    const double range = maxVal - minVal;
+    for (int i = 0; i < tilesH && written; i++) {
+        for (int j = 0; j < tilesW && written; j++) {
+            std::fill(floats.begin(), floats.end(), 0.0f);
+            std::fill(shorts.begin(), shorts.end(), 0);
+            for (int r = 0; r < tileSize && i * tileSize + r < (int)header.H; r++) {
+                const std::vector<double> &row = grid[i * tileSize + r];
+                for (int c = 0; c < tileSize && j * tileSize + c < (int)header.W; c++) {
+                    const double value = row[j * tileSize + c];
+                    if (type == MAPFILE_FLOAT32) {floats[(unsigned long int)r * tileSize + c] = littleEndian((float)value);}
+                    else {shorts[(unsigned long int)r * tileSize + c] = littleEndian(range > 0.0 ? (std::uint16_t)std::lround(std::min(std::max((value - minVal) / range, 0.0), 1.0) * 65535.0) : (std::uint16_t)0);}
+                }
+            }
+
+            const unsigned char* bytes = type == MAPFILE_FLOAT32 ? (const unsigned char*)floats.data() : (const unsigned char*)shorts.data();
+            const unsigned long int size = cells * valueBytes(type);
+            if (checksums) {sums.push_back(littleEndian(crc32(bytes, size)));}
+            written = std::fwrite(bytes, size, 1, file) == 1;
+        }
+    }
+    if (written && checksums) {written = std::fseek(file, header.ChecksumOffset, SEEK_SET) == 0 && std::fwrite(sums.data(), sums.size() * sizeof(std::uint32_t), 1, file) == 1;}
+
+    written = std::fclose(file) == 0 && written;
+#ifdef _WIN32
+    // rename() won't replace an existing file on Windows
+    if (written) {written = MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;}
+#else
+    if (written) {written = std::rename(temp.c_str(), path.c_str()) == 0;}
+#endif
+    if (!written) {
+        std::cout << "Failed to save map file\nERROR: " << std::strerror(errno) << "\n";
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
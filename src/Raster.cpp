@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <cstdlib>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "Raster.hpp"
+
+Raster::Raster(const int &w, const int &h) {resize(w, h);}
+
+void Raster::resize(const int &w, const int &h) {
+    W = std::max(w, 0);
+    H = std::max(h, 0);
+    Pixels.assign((unsigned long int)W * H, 0);
+    DirtyX1 = 0;
+    DirtyY1 = 0;
+    DirtyX2 = -1;
+    DirtyY2 = -1;
+}
+int Raster::getW() const {return W;}
+int Raster::getH() const {return H;}
+const Uint32* Raster::getPixels() const {return Pixels.data();}
+int Raster::getPitch() const {return W * sizeof(Uint32);}
+
+bool Raster::isDirty() const {return DirtyX1 <= DirtyX2 && DirtyY1 <= DirtyY2;}
+SDL_Rect Raster::getDirty() const {
+    if (!isDirty()) {return {0, 0, 0, 0};}
+    return {DirtyX1, DirtyY1, DirtyX2 - DirtyX1 + 1, DirtyY2 - DirtyY1 + 1};
+}
+void Raster::clearDirty() {
+    if (isDirty()) {
+        for (int y = DirtyY1; y <= DirtyY2; y++) {span(DirtyX1, DirtyX2, y, 0);}
+    }
+    DirtyX1 = 0;
+    DirtyY1 = 0;
+    DirtyX2 = -1;
+    DirtyY2 = -1;
+}
+
+void Raster::touch(const int &x1, const int &y1, const int &x2, const int &y2) {
+    const int left = std::max(std::min(x1, x2), 0), right = std::min(std::max(x1, x2), W - 1);
+    const int top = std::max(std::min(y1, y2), 0), bottom = std::min(std::max(y1, y2), H - 1);
+    if (left > right || top > bottom) {return;}
+    if (!isDirty()) {
+        DirtyX1 = left;
+        DirtyY1 = top;
+        DirtyX2 = right;
+        DirtyY2 = bottom;
+        return;
+    }
+    DirtyX1 = std::min(DirtyX1, left);
+    DirtyY1 = std::min(DirtyY1, top);
+    DirtyX2 = std::max(DirtyX2, right);
+    DirtyY2 = std::max(DirtyY2, bottom);
+}
+
+Uint32 Raster::pack(const SDL_Color &color) {return (Uint32)color.a << 24 | (Uint32)color.r << 16 | (Uint32)color.g << 8 | (Uint32)color.b;}
+
+void Raster::span(int x1, int x2, const int &y, const Uint32 &color) {
+    if (y < 0 || y >= H) {return;}
+    if (x1 > x2) {std::swap(x1, x2);}
+    x1 = std::max(x1, 0);
+    x2 = std::min(x2, W - 1);
+    if (x1 > x2) {return;}
+
+    Uint32* dst = Pixels.data() + (unsigned long int)y * W + x1;
+    int count = x2 - x1 + 1;
+#if defined(__SSE2__)
+    // Four pixels per store; the tail (and builds without SSE2) falls through to the plain loop
+    const __m128i fill = _mm_set1_epi32((int)color);
+    for (; count >= 8; count -= 8, dst += 8) {
+        _mm_storeu_si128((__m128i*)dst, fill);
+        _mm_storeu_si128((__m128i*)(dst + 4), fill);
+    }
+    for (; count >= 4; count -= 4, dst += 4) {_mm_storeu_si128((__m128i*)dst, fill);}
+#endif
+    for (; count > 0; count--) {*dst++ = color;}
+}
+
+void Raster::line(const int &x1, const int &y1, const int &x2, const int &y2, const Uint32 &color) {
+    if (y1 == y2) {
+        span(x1, x2, y1, color);
+        return;
+    }
+    const int dx = std::abs(x2 - x1), dy = -std::abs(y2 - y1);
+    const int sx = x1 < x2 ? 1 : -1, sy = y1 < y2 ? 1 : -1;
+    int x = x1, y = y1, error = dx + dy;
+    while (true) {
+        plot(x, y, color);
+        if (x == x2 && y == y2) {break;}
+        const int error2 = error * 2;
+        if (error2 >= dy) {
+            error += dy;
+            x += sx;
+        }
+        if (error2 <= dx) {
+            error += dx;
+            y += sy;
+        }
+    }
+}
+
+void Raster::lineOverlap(const int &x1, const int &y1, const int &x2, const int &y2, const unsigned char &overlapType, const Uint32 &color) {
+    if (x1 == x2 || y1 == y2 || overlapType == LINE_OVERLAP_NONE) {
+        line(x1, y1, x2, y2, color);
+        return;
+    }
+    int dx = x2 - x1, dy = y2 - y1;
+    int sx = 1, sy = 1;
+
+    if (dx < 0) {
+        dx = -dx;
+        sx = -1;
+    }
+    if (dy < 0) {
+        dy = -dy;
+        sy = -1;
+    }
+    int x = x1, y = y1, error = 0;
+    const int dx2 = dx * 2;
+    const int dy2 = dy * 2;
+
+    plot(x, y, color);
+    if (dx > dy) {
+        error = dy2 - dx;
+        while (x != x2) {
+            x += sx;
+            if (error >= 0) {
+                if (overlapType == LINE_OVERLAP_MAJOR || overlapType == LINE_OVERLAP_BOTH) {plot(x, y, color);}
+                y += sy;
+                if (overlapType == LINE_OVERLAP_MINOR || overlapType == LINE_OVERLAP_BOTH) {plot(x - sx, y, color);}
+                error -= dx2;
+            }
+            error += dy2;
+            plot(x, y, color);
+        }
+        return;
+    }
+    error = dx2 - dy;
+    while (y != y2) {
+        y += sy;
+        if (error >= 0) {
+            if (overlapType == LINE_OVERLAP_MAJOR || overlapType == LINE_OVERLAP_BOTH) {plot(x, y, color);}
+            x += sx;
+            if (overlapType == LINE_OVERLAP_MINOR || overlapType == LINE_OVERLAP_BOTH) {plot(x, y - sy, color);}
+            error -= dy2;
+        }
+        error += dx2;
+        plot(x, y, color);
+    }
+}
+
+void Raster::drawPixel(const int &x, const int &y, const SDL_Color &color) {
+    touch(x, y, x, y);
+    plot(x, y, pack(color));
+}
+void Raster::fillSpan(const int &x1, const int &x2, const int &y, const SDL_Color &color) {
+    touch(x1, y, x2, y);
+    span(x1, x2, y, pack(color));
+}
+void Raster::fillRectangle(const SDL_Rect &rect, const SDL_Color &color) {
+    if (rect.w <= 0 || rect.h <= 0) {return;}
+    touch(rect.x, rect.y, rect.x + rect.w - 1, rect.y + rect.h - 1);
+    const Uint32 packed = pack(color);
+    for (int y = std::max(rect.y, 0); y < std::min(rect.y + rect.h, H); y++) {span(rect.x, rect.x + rect.w - 1, y, packed);}
+}
+void Raster::drawLine(const int &x1, const int &y1, const int &x2, const int &y2, const SDL_Color &color) {
+    touch(x1, y1, x2, y2);
+    line(x1, y1, x2, y2, pack(color));
+}
+void Raster::drawLineOverlap(const int &x1, const int &y1, const int &x2, const int &y2, const unsigned char &overlapType, const SDL_Color &color) {
+    touch(x1, y1, x2, y2);
+    lineOverlap(x1, y1, x2, y2, overlapType, pack(color));
+}
+
+/**
+ * Bresenham with thickness
+ * The line is drawn as thickness parallel lines, each one stepped along the perpendicular of the main line with overlap pixels between them, so no pixel is missed and every pixel is only drawn once
+ * A thickness of 1 or less draws a plain line
+ * thicknessMode can be one of LINE_THICKNESS_MIDDLE, LINE_THICKNESS_DRAW_CLOCKWISE, LINE_THICKNESS_DRAW_COUNTERCLOCKWISE
+ */
+void Raster::drawThickLine(const int &x1, const int &y1, const int &x2, const int &y2, const int &thickness, const unsigned char &thicknessMode, const SDL_Color &color) {
+    const Uint32 packed = pack(color);
+    if (thickness <= 1) {
+        touch(x1, y1, x2, y2);
+        line(x1, y1, x2, y2, packed);
+        return;
+    }
+    touch(std::min(x1, x2) - thickness, std::min(y1, y2) - thickness, std::max(x1, x2) + thickness, std::max(y1, y2) + thickness);
+
+    // The deltas are swapped on purpose: the lines are stepped along the perpendicular of the main line
+    int dx = y2 - y1, dy = x2 - x1;
+    int sx = 1, sy = 1;
+    bool swap = true;
+
+    if (dx < 0) {
+        dx = -dx;
+        sx = -1;
+        swap = !swap;
+    }
+    if (dy < 0) {
+        dy = -dy;
+        sy = -1;
+        swap = !swap;
+    }
+
+    int xs = x1, xe = x2, ys = y1, ye = y2, error = 0;
+    const int dx2 = dx * 2;
+    const int dy2 = dy * 2;
+    unsigned char overlap;
+
+    int drawAdjust = thickness / 2;
+    if (thicknessMode == LINE_THICKNESS_DRAW_COUNTERCLOCKWISE) {
+        drawAdjust = thickness - 1;
+    } else if (thicknessMode == LINE_THICKNESS_DRAW_CLOCKWISE) {
+        drawAdjust = 0;
+    }
+
+    if (dx >= dy) {
+        if (swap) {
+            drawAdjust = thickness - drawAdjust - 1;
+            sy = -sy;
+        } else {
+            sx = -sx;
+        }
+        error = dy2 - dx;
+        for (int i = drawAdjust; i > 0; i--) {
+            xs -= sx;
+            xe -= sx;
+            if (error >= 0) {
+                ys -= sy;
+                ye -= sy;
+                error -= dx2;
+            }
+            error += dy2;
+        }
+        line(xs, ys, xe, ye, packed);
+
+        error = dy2 - dx;
+        for (int i = thickness; i > 1; i--) {
+            xs += sx;
+            xe += sx;
+            overlap = LINE_OVERLAP_NONE;
+            if (error >= 0) {
+                ys += sy;
+                ye += sy;
+                error -= dx2;
+                overlap = LINE_OVERLAP_MAJOR;
+            }
+            error += dy2;
+            lineOverlap(xs, ys, xe, ye, overlap, packed);
+        }
+        return;
+    }
+
+    if (swap) {
+        sx = -sx;
+    } else {
+        drawAdjust = thickness - drawAdjust - 1;
+        sy = -sy;
+    }
+    error = dx2 - dy;
+    for (int i = drawAdjust; i > 0; i--) {
+        ys -= sy;
+        ye -= sy;
+        if (error >= 0) {
+            xs -= sx;
+            xe -= sx;
+            error -= dy2;
+        }
+        error += dx2;
+    }
+    line(xs, ys, xe, ye, packed);
+
+    error = dx2 - dy;
+    for (int i = thickness; i > 1; i--) {
+        ys += sy;
+        ye += sy;
+        overlap = LINE_OVERLAP_NONE;
+        if (error >= 0) {
+            xs += sx;
+            xe += sx;
+            error -= dy2;
+            overlap = LINE_OVERLAP_MAJOR;
+        }
+        error += dx2;
+        lineOverlap(xs, ys, xe, ye, overlap, packed);
+    }
+}
+
+void Raster::drawCircle(const int &x, const int &y, const int &r, const SDL_Color &color) {
+    touch(x - r, y - r, x + r, y + r);
+    const Uint32 packed = pack(color);
+    const int diameter = r * 2;
+    int ox    = r - 1;    int oy = 0;
+    int tx    = 1;        int ty = 1;
+    int error = tx - diameter;
+    while (ox >= oy) {
+        plot(x + ox, y - oy, packed);
+        plot(x + ox, y + oy, packed);
+        plot(x - ox, y - oy, packed);
+        plot(x - ox, y + oy, packed);
+        plot(x + oy, y - ox, packed);
+        plot(x + oy, y + ox, packed);
+        plot(x - oy, y - ox, packed);
+        plot(x - oy, y + ox, packed);
+        if (error <= 0) {
+            oy++;
+            error += ty;
+            ty    += 2;
+        } else if (error > 0) {
+            ox--;
+            tx    += 2;
+            error += tx - diameter;
+        }
+    }
+}
+void Raster::fillCircle(const int &x, const int &y, const int &r, const SDL_Color &color) {
+    touch(x - r, y - r, x + r, y + r);
+    const Uint32 packed = pack(color);
+    int ox    = 0;    int oy = r;
+    int error = r - 1;
+    while (oy >= ox) {
+        span(x - oy, x + oy, y + ox, packed);
+        span(x - ox, x + ox, y + oy, packed);
+        span(x - ox, x + ox, y - oy, packed);
+        span(x - oy, x + oy, y - ox, packed);
+        if (error >= ox * 2) {
+            error -= ox * 2 + 1;
+            ox++;
+        } else if (error < 2 * (r - oy)) {
+            error += oy * 2 - 1;
+            oy--;
+        } else {
+            error += 2 * (oy - ox - 1);
+            oy--;
+            ox++;
+        }
+    }
+}
@@ -1,34 +1,68 @@
+#include <algorithm>
+#include <cmath>
+
 #include "RenderWindow.hpp"
+#include "Utilities.hpp"
 
 RenderWindow::RenderWindow(const char* title, const int &w, const int &h, Uint32 flags) : Window(NULL), Renderer(NULL), W(w), H(h), W_2(w / 2), H_2(h / 2) {
     if ((Window = SDL_CreateWindow(title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, w, h, flags)) == NULL) {std::cout << "Window \"" << title << "\" failed to initialize\nERROR: " << SDL_GetError() << "\n";}
-    if ((Renderer = SDL_CreateRenderer(Window, -1, SDL_RENDERER_ACCELERATED)) == NULL) {std::cout << "Renderer for \"" << title << "\" failed to initialize\nERROR: " << SDL_GetError() << "\n";}
+    if ((Renderer = SDL_CreateRenderer(Window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE)) == NULL) {std::cout << "Renderer for \"" << title << "\" failed to initialize\nERROR: " << SDL_GetError() << "\n";}
+    damageAll();
+}
+RenderWindow::RenderWindow(const int &w, const int &h) : Window(NULL), Renderer(NULL), W(w), H(h), W_2(w / 2), H_2(h / 2) {
+    if ((Surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888)) == NULL) {std::cout << "Headless frame failed to initialize\nERROR: " << SDL_GetError() << "\n";}
+    else if ((Renderer = SDL_CreateSoftwareRenderer(Surface)) == NULL) {std::cout << "Headless renderer failed to initialize\nERROR: " << SDL_GetError() << "\n";}
+    damageAll();
 }
 RenderWindow::~RenderWindow() {
+    Atlases.clear();
+    for (std::unordered_map<int, Layer>::iterator i = Layers.begin(); i != Layers.end(); i++) {SDL_DestroyTexture(i->second.Target);}
+    SDL_DestroyTexture(ViewTexture);
+    SDL_DestroyTexture(HeatTexture);
+    SDL_DestroyTexture(MaskTexture);
+    SDL_DestroyTexture(BackBuffer);
+    SDL_DestroyTexture(OverlayTexture);
     SDL_DestroyRenderer(Renderer);
     SDL_DestroyWindow(Window);
+    SDL_FreeSurface(Surface);
+}
+
+bool RenderWindow::isHeadless() const {return Window == NULL;}
+void RenderWindow::applySize() {
+    if (Window != NULL) {
+        SDL_SetWindowSize(Window, W, H);
+        return;
+    }
+    // Every texture belongs to the renderer, so a new frame size would mean starting over
+    std::cout << "Headless frames cannot be resized\n";
+    W = Surface != NULL ? Surface->w : 0;
+    H = Surface != NULL ? Surface->h : 0;
+    W_2 = W / 2;
+    H_2 = H / 2;
 }
 
 int RenderWindow::getRefreshRate() const {
+    if (Window == NULL) {return RENDER_HEADLESS_REFRESH_RATE;}
     SDL_DisplayMode mode;
     SDL_GetDisplayMode(SDL_GetWindowDisplayIndex(Window), 0, &mode);
     return mode.refresh_rate;
 }
-Uint32 RenderWindow::getWindowFlags() {return SDL_GetWindowFlags(Window);}
+// Headless frames have no window, so no flags & no title
+Uint32 RenderWindow::getWindowFlags() {return Window != NULL ? SDL_GetWindowFlags(Window) : 0;}
 
 int RenderWindow::getW() const {return W;}
 int RenderWindow::setW(const int &w) {
     const int output = W;
     W = w;
     W_2 = W / 2;
-    SDL_SetWindowSize(Window, W, H);
+    applySize();
     return output;
 }
 int RenderWindow::adjustW(const int &amount) {
     const int output = W;
     W += amount;
     W_2 = W / 2;
-    SDL_SetWindowSize(Window, W, H);
+    applySize();
     return output;
 }
 int RenderWindow::getH() const {return H;}
@@ -36,14 +70,14 @@ int RenderWindow::setH(const int &h) {
     const int output = H;
     H = h;
     H_2 = H / 2;
-    SDL_SetWindowSize(Window, W, H);
+    applySize();
     return output;
 }
 int RenderWindow::adjustH(const int &amount) {
     const int output = W;
     H += amount;
     H_2 = H / 2;
-    SDL_SetWindowSize(Window, W, H);
+    applySize();
     return output;
 }
 SDL_Point RenderWindow::getDims() const {return {W, H};}
@@ -53,7 +87,7 @@ SDL_Point RenderWindow::setDims(const int &w, const int &h) {
     W_2 = W / 2;
     H = h;
     H_2 = H / 2;
-    SDL_SetWindowSize(Window, W, H);
+    applySize();
     return output;
 }
 SDL_Point RenderWindow::adjustDims(const int &w, const int &h) {
@@ -62,11 +96,12 @@ SDL_Point RenderWindow::adjustDims(const int &w, const int &h) {
     W_2 = W / 2;
     H += h;
     H_2 = H / 2;
-    SDL_SetWindowSize(Window, W, H);
+    applySize();
     return output;
 }
 SDL_Point RenderWindow::updateDims() {
     const SDL_Point output = {W, H};
+    if (Window == NULL) {return output;}
     SDL_GetWindowSize(Window, &W, &H);
     W_2 = W / 2;
     H_2 = H / 2;
@@ -75,103 +110,233 @@ SDL_Point RenderWindow::updateDims() {
 int RenderWindow::getW_2() const {return W_2;}
 int RenderWindow::getH_2() const {return H_2;}
 
-const char* RenderWindow::getTitle() const {return SDL_GetWindowTitle(Window);}
+const char* RenderWindow::getTitle() const {return Window != NULL ? SDL_GetWindowTitle(Window) : "";}
 const char* RenderWindow::setTitle(const char* title) {
     const char* output = getTitle();
-    SDL_SetWindowTitle(Window, title);
+    if (Window != NULL) {SDL_SetWindowTitle(Window, title);}
     return output;
 }
 
 void RenderWindow::clear(const SDL_Color &color) {
+    flushBatch();
     SDL_SetRenderDrawColor(Renderer, color.r, color.g, color.b, color.a);
-    SDL_RenderClear(Renderer);
+    // SDL_RenderClear() ignores the clip rectangle
+    if (Repainting && ActiveLayer == -1) {SDL_RenderFillRect(Renderer, &RepaintClip);}
+    else {SDL_RenderClear(Renderer);}
+    DrawCalls++;
+}
+void RenderWindow::show() {
+    flushBatch();
+    for (std::unordered_map<TTF_Font*, std::unique_ptr<GlyphAtlas>>::iterator i = Atlases.begin(); i != Atlases.end(); i++) {i->second->releaseRetired();}
+    SDL_RenderPresent(Renderer);
+    FrameDrawCalls = DrawCalls;
+    DrawCalls = 0;
+
+    const Uint64 now = SDL_GetPerformanceCounter();
+    if (LastShow != 0) {FrameTime = (double)(now - LastShow) / SDL_GetPerformanceFrequency();}
+    LastShow = now;
+    FrameCount++;
+}
+
+void RenderWindow::batch(const unsigned char &type, const SDL_Color &color) {
+    const bool sameColor = color.r == BatchColor.r && color.g == BatchColor.g && color.b == BatchColor.b && color.a == BatchColor.a;
+    if (BatchType != RENDER_BATCH_NONE && (type != BatchType || (type != RENDER_BATCH_FILLS && type != RENDER_BATCH_TEXTURED && type != RENDER_BATCH_RASTER && !sameColor))) {flushBatch();}
+    BatchType = type;
+    BatchColor = color;
+}
+Raster& RenderWindow::beginRaster() {
+    batch(RENDER_BATCH_RASTER, BatchColor);
+    if (Overlay.getW() != W || Overlay.getH() != H) {Overlay.resize(W, H);}
+    return Overlay;
+}
+void RenderWindow::queuePoint(const int &x, const int &y, const SDL_Color &color) {
+    batch(RENDER_BATCH_POINTS, color);
+    BatchPoints.push_back({x, y});
+}
+void RenderWindow::queueLine(const int &x1, const int &y1, const int &x2, const int &y2, const SDL_Color &color) {
+    batch(RENDER_BATCH_LINES, color);
+    if (!BatchPoints.empty() && (BatchPoints.back().x != x1 || BatchPoints.back().y != y1)) {
+        flushBatch();
+        batch(RENDER_BATCH_LINES, color);
+    }
+    if (BatchPoints.empty()) {BatchPoints.push_back({x1, y1});}
+    BatchPoints.push_back({x2, y2});
+}
+void RenderWindow::queueOutline(const SDL_Rect &rect, const SDL_Color &color) {
+    batch(RENDER_BATCH_OUTLINES, color);
+    BatchRects.push_back(rect);
+}
+void RenderWindow::queueFill(const SDL_Rect &rect, const SDL_Color &color) {
+    if (rect.w <= 0 || rect.h <= 0) {return;}
+    batch(RENDER_BATCH_FILLS, color);
+    const int first = BatchVertices.size();
+    const float x1 = rect.x, y1 = rect.y, x2 = rect.x + rect.w, y2 = rect.y + rect.h;
+    BatchVertices.push_back({{x1, y1}, color, {0.0f, 0.0f}});
+    BatchVertices.push_back({{x2, y1}, color, {0.0f, 0.0f}});
+    BatchVertices.push_back({{x2, y2}, color, {0.0f, 0.0f}});
+    BatchVertices.push_back({{x1, y2}, color, {0.0f, 0.0f}});
+    const int indices[6] = {first, first + 1, first + 2, first, first + 2, first + 3};
+    BatchIndices.insert(BatchIndices.end(), indices, indices + 6);
+}
+void RenderWindow::queueGeometry(SDL_Texture* texture, const std::vector<SDL_Vertex> &vertices, const std::vector<int> &indices, const float &x, const float &y, const SDL_Color &color) {
+    if (vertices.empty()) {return;}
+    if (BatchType == RENDER_BATCH_TEXTURED && BatchTexture != texture) {flushBatch();}
+    batch(RENDER_BATCH_TEXTURED, color);
+    BatchTexture = texture;
+
+    const int first = BatchVertices.size();
+    for (unsigned long int i = 0; i < vertices.size(); i++) {
+        SDL_Vertex vertex = vertices[i];
+        vertex.position.x += x;
+        vertex.position.y += y;
+        vertex.color = {(Uint8)(vertex.color.r * color.r / 255), (Uint8)(vertex.color.g * color.g / 255), (Uint8)(vertex.color.b * color.b / 255), (Uint8)(vertex.color.a * color.a / 255)};
+        BatchVertices.push_back(vertex);
+    }
+    for (unsigned long int i = 0; i < indices.size(); i++) {BatchIndices.push_back(first + indices[i]);}
+}
+void RenderWindow::queueSprite(const Texture &texture, const SDL_Rect &dst) {
+    const TextureAtlas* atlas = texture.getAtlas();
+    if (dst.w <= 0 || dst.h <= 0 || atlas->getTexture() == NULL) {return;}
+    if (BatchType == RENDER_BATCH_TEXTURED && BatchTexture != atlas->getTexture()) {flushBatch();}
+    batch(RENDER_BATCH_TEXTURED, texture.getColorMod());
+    BatchTexture = atlas->getTexture();
+
+    const SDL_Rect frame = texture.getFrame();
+    float u1 = (float)frame.x / atlas->getW(), v1 = (float)frame.y / atlas->getH(), u2 = (float)(frame.x + frame.w) / atlas->getW(), v2 = (float)(frame.y + frame.h) / atlas->getH();
+    if (texture.getFlip() & SDL_FLIP_HORIZONTAL) {std::swap(u1, u2);}
+    if (texture.getFlip() & SDL_FLIP_VERTICAL) {std::swap(v1, v2);}
+
+    // Angles go counterclockwise with y up, which is clockwise on screen by -angle
+    const SDL_Point center = texture.getCenter();
+    const float c = texture.getAngleCos(), s = texture.getAngleSin();
+    const float cx = dst.x + center.x, cy = dst.y + center.y;
+    const float corners[4][4] = {{0.0f, 0.0f, u1, v1}, {(float)dst.w, 0.0f, u2, v1}, {(float)dst.w, (float)dst.h, u2, v2}, {0.0f, (float)dst.h, u1, v2}};
+
+    const int first = BatchVertices.size();
+    const SDL_Color color = texture.getColorMod();
+    for (int i = 0; i < 4; i++) {
+        const float dx = corners[i][0] - center.x, dy = corners[i][1] - center.y;
+        BatchVertices.push_back({{cx + dx * c + dy * s, cy - dx * s + dy * c}, color, {corners[i][2], corners[i][3]}});
+    }
+    const int indices[6] = {first, first + 1, first + 2, first, first + 2, first + 3};
+    BatchIndices.insert(BatchIndices.end(), indices, indices + 6);
+}
+void RenderWindow::flushBatch() {
+    switch (BatchType) {
+        case RENDER_BATCH_POINTS:
+            SDL_SetRenderDrawColor(Renderer, BatchColor.r, BatchColor.g, BatchColor.b, BatchColor.a);
+            SDL_RenderDrawPoints(Renderer, BatchPoints.data(), BatchPoints.size());
+            DrawCalls++;
+            break;
+        case RENDER_BATCH_LINES:
+            SDL_SetRenderDrawColor(Renderer, BatchColor.r, BatchColor.g, BatchColor.b, BatchColor.a);
+            SDL_RenderDrawLines(Renderer, BatchPoints.data(), BatchPoints.size());
+            DrawCalls++;
+            break;
+        case RENDER_BATCH_OUTLINES:
+            SDL_SetRenderDrawColor(Renderer, BatchColor.r, BatchColor.g, BatchColor.b, BatchColor.a);
+            SDL_RenderDrawRects(Renderer, BatchRects.data(), BatchRects.size());
+            DrawCalls++;
+            break;
+        case RENDER_BATCH_FILLS:
+            SDL_RenderGeometry(Renderer, NULL, BatchVertices.data(), BatchVertices.size(), BatchIndices.data(), BatchIndices.size());
+            DrawCalls++;
+            break;
+        case RENDER_BATCH_TEXTURED:
+            SDL_RenderGeometry(Renderer, BatchTexture, BatchVertices.data(), BatchVertices.size(), BatchIndices.data(), BatchIndices.size());
+            DrawCalls++;
+            break;
+        case RENDER_BATCH_RASTER:
+            if (Overlay.isDirty()) {
+                int w = 0, h = 0;
+                if (OverlayTexture != NULL) {SDL_QueryTexture(OverlayTexture, NULL, NULL, &w, &h);}
+                if (OverlayTexture == NULL || w != Overlay.getW() || h != Overlay.getH()) {
+                    SDL_DestroyTexture(OverlayTexture);
+                    if ((OverlayTexture = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, Overlay.getW(), Overlay.getH())) == NULL) {std::cout << "Failed to create overlay texture\nERROR: " << SDL_GetError() << "\n";}
+                    SDL_SetTextureBlendMode(OverlayTexture, SDL_BLENDMODE_BLEND);
+                }
+                if (OverlayTexture != NULL) {
+                    const SDL_Rect dirty = Overlay.getDirty();
+                    SDL_UpdateTexture(OverlayTexture, &dirty, Overlay.getPixels() + (unsigned long int)dirty.y * Overlay.getW() + dirty.x, Overlay.getPitch());
+                    SDL_RenderCopy(Renderer, OverlayTexture, &dirty, &dirty);
+                    DrawCalls++;
+                }
+                Overlay.clearDirty();
+            }
+            break;
+    }
+    BatchTexture = NULL;
+    BatchPoints.clear();
+    BatchRects.clear();
+    BatchVertices.clear();
+    BatchIndices.clear();
+    BatchType = RENDER_BATCH_NONE;
+}
+unsigned long int RenderWindow::getDrawCalls() const {return FrameDrawCalls;}
+double RenderWindow::getFrameTime() const {return FrameTime;}
+unsigned long int RenderWindow::getFrameCount() const {return FrameCount;}
+
+bool RenderWindow::saveFrame(const std::string &path) {
+    flushBatch();
+    SDL_Surface* frame = Surface;
+    if (frame == NULL || BackBuffer != NULL) {
+        if ((frame = SDL_CreateRGBSurfaceWithFormat(0, W, H, 32, SDL_PIXELFORMAT_ARGB8888)) == NULL) {
+            std::cout << "Failed to create surface for \"" << path << "\"\nERROR: " << SDL_GetError() << "\n";
+            return false;
+        }
+        if (BackBuffer != NULL) {SDL_SetRenderTarget(Renderer, BackBuffer);}
+        const int read = SDL_RenderReadPixels(Renderer, NULL, SDL_PIXELFORMAT_ARGB8888, frame->pixels, frame->pitch);
+        if (BackBuffer != NULL) {SDL_SetRenderTarget(Renderer, FrameTarget);}
+        if (read != 0) {
+            std::cout << "Failed to read frame for \"" << path << "\"\nERROR: " << SDL_GetError() << "\n";
+            SDL_FreeSurface(frame);
+            return false;
+        }
+    }
+
+    const bool output = IMG_SavePNG(frame, path.c_str()) == 0;
+    if (!output) {std::cout << "Failed to save \"" << path << "\"\nERROR: " << IMG_GetError() << "\n";}
+    if (frame != Surface) {SDL_FreeSurface(frame);}
+    return output;
 }
-void RenderWindow::show() {SDL_RenderPresent(Renderer);}
 
 bool RenderWindow::toggleFullscreen(const bool &trueFullscreen) {
     const bool output = IsFullscreen;
+    if (Window == NULL) {return output;}
     if   (!IsFullscreen) {SDL_SetWindowFullscreen(Window, trueFullscreen ? SDL_WINDOW_FULLSCREEN : SDL_WINDOW_FULLSCREEN_DESKTOP);}
     else                 {SDL_SetWindowFullscreen(Window, SDL_FALSE);}
     IsFullscreen = !IsFullscreen;
     updateDims();
     return output;
 }
-void RenderWindow::centerMouse() {SDL_WarpMouseInWindow(Window, W_2, H_2);}
+void RenderWindow::centerMouse() {if (Window != NULL) {SDL_WarpMouseInWindow(Window, W_2, H_2);}}
 
 void RenderWindow::handleEvent(const SDL_WindowEvent &event) {
     switch (event.event) {
         case SDL_WINDOWEVENT_RESIZED:
         case SDL_WINDOWEVENT_SIZE_CHANGED:
             updateDims();
+            invalidateLayers();
+            break;
+        case SDL_WINDOWEVENT_EXPOSED:
+            damageAll();
             break;
     }
 }
 
-void RenderWindow::drawPixel(const int &x, const int &y, const SDL_Color &color) {
-    SDL_SetRenderDrawColor(Renderer, color.r, color.g, color.b, color.a);
-    SDL_RenderDrawPoint(Renderer, W_2 + x, H_2 - y);
-}
-void RenderWindow::drawLine(const int &x1, const int &y1, const int &x2, const int &y2, const SDL_Color &color) {
-    SDL_SetRenderDrawColor(Renderer, color.r, color.g, color.b, color.a);
-    SDL_RenderDrawLine(Renderer, W_2 + x1, H_2 - y1, W_2 + x2, H_2 - y2);
-}
-void RenderWindow::drawRectangle(const int &x, const int &y, const int &w, const int &h, const SDL_Color &color) {
-    SDL_SetRenderDrawColor(Renderer, color.r, color.g, color.b, color.a);
-    SDL_Rect dst = {W_2 + x, H_2 - y, w, h};
-    SDL_RenderDrawRect(Renderer, &dst);
-}
-void RenderWindow::fillRectangle(const int &x, const int &y, const int &w, const int &h, const SDL_Color &color) {
-    SDL_SetRenderDrawColor(Renderer, color.r, color.g, color.b, color.a);
-    SDL_Rect dst = {W_2 + x, H_2 - y, w, h};
-    SDL_RenderFillRect(Renderer, &dst);
-}
-void RenderWindow::drawCircle(const int &x, const int &y, const int &r, const SDL_Color &color) {
-    SDL_SetRenderDrawColor(Renderer, color.r, color.g, color.b, color.a);
-    const int diameter = r * 2;
-    int ox    = r - 1;    int oy = 0;
-    int tx    = 1;        int ty = 1;
-    int error = tx - diameter;
-    while (ox >= oy) {
-        SDL_RenderDrawPoint(Renderer, W_2 + x + ox, H_2 - y - oy);
-        SDL_RenderDrawPoint(Renderer, W_2 + x + ox, H_2 - y + oy);
-        SDL_RenderDrawPoint(Renderer, W_2 + x - ox, H_2 - y - oy);
-        SDL_RenderDrawPoint(Renderer, W_2 + x - ox, H_2 - y + oy);
-        SDL_RenderDrawPoint(Renderer, W_2 + x + oy, H_2 - y - ox);
-        SDL_RenderDrawPoint(Renderer, W_2 + x + oy, H_2 - y + ox);
-        SDL_RenderDrawPoint(Renderer, W_2 + x - oy, H_2 - y - ox);
-        SDL_RenderDrawPoint(Renderer, W_2 + x - oy, H_2 - y + ox);
-        if (error <= 0) {
-            oy++;
-            error += ty;
-            ty    += 2;
-        } else if (error > 0) {
-            ox--;
-            tx    += 2;
-            error += tx - diameter;
-        }
-    }
-}
-void RenderWindow::fillCircle(const int &x, const int &y, const int &r, const SDL_Color &color) {
-    SDL_SetRenderDrawColor(Renderer, color.r, color.g, color.b, color.a);
-    int ox    = 0;    int oy = r;
-    int error = r - 1;
-    while (oy >= ox) {
-        SDL_RenderDrawLine(Renderer, W_2 + x - oy, H_2 - y + ox, W_2 + x + oy, H_2 - y + ox);
-        SDL_RenderDrawLine(Renderer, W_2 + x - ox, H_2 - y + oy, W_2 + x + ox, H_2 - y + oy);
-        SDL_RenderDrawLine(Renderer, W_2 + x - ox, H_2 - y - oy, W_2 + x + ox, H_2 - y - oy);
-        SDL_RenderDrawLine(Renderer, W_2 + x - oy, H_2 - y - ox, W_2 + x + oy, H_2 - y - ox);
-        if (error >= ox * 2) {
-            error -= ox * 2 + 1;
-            ox++;
-        } else if (error < 2 * (r - oy)) {
-            error += oy * 2 - 1;
-            oy--;;
-        } else {
-            error += 2 * (oy - ox - 1);
-            oy--;
-            ox++;
-        }
-    }
+void RenderWindow::drawPixel(const int &x, const int &y, const SDL_Color &color) {queuePoint(W_2 + x, H_2 - y, color);}
+void RenderWindow::drawLine(const int &x1, const int &y1, const int &x2, const int &y2, const SDL_Color &color) {queueLine(W_2 + x1, H_2 - y1, W_2 + x2, H_2 - y2, color);}
+void RenderWindow::drawRectangle(const int &x, const int &y, const int &w, const int &h, const SDL_Color &color) {queueOutline({W_2 + x, H_2 - y, w, h}, color);}
+void RenderWindow::fillRectangle(const int &x, const int &y, const int &w, const int &h, const SDL_Color &color) {queueFill({W_2 + x, H_2 - y, w, h}, color);}
+void RenderWindow::drawCircle(const int &x, const int &y, const int &r, const SDL_Color &color) {beginRaster().drawCircle(W_2 + x, H_2 - y, r, color);}
+void RenderWindow::fillCircle(const int &x, const int &y, const int &r, const SDL_Color &color) {beginRaster().fillCircle(W_2 + x, H_2 - y, r, color);}
+void RenderWindow::drawLineOverlap(const int &x1, const int &y1, const int &x2, const int &y2, const unsigned char overlapType, const SDL_Color &color) {beginRaster().drawLineOverlap(W_2 + x1, H_2 - y1, W_2 + x2, H_2 - y2, overlapType, color);}
+void RenderWindow::drawThickLine(const int x1, const int y1, const int x2, const int y2, const int thickness, const unsigned char thicknessMode, const SDL_Color &color) {
+    // Flipping y to get to renderer coordinates mirrors the line, so its sides swap
+    unsigned char mode = thicknessMode;
+    if (thicknessMode == LINE_THICKNESS_DRAW_CLOCKWISE) {mode = LINE_THICKNESS_DRAW_COUNTERCLOCKWISE;}
+    else if (thicknessMode == LINE_THICKNESS_DRAW_COUNTERCLOCKWISE) {mode = LINE_THICKNESS_DRAW_CLOCKWISE;}
+    beginRaster().drawThickLine(W_2 + x1, H_2 - y1, W_2 + x2, H_2 - y2, thickness, mode, color);
 }
 
 SDL_Texture* RenderWindow::loadTexture(const std::string &path) {
@@ -180,197 +345,421 @@ SDL_Texture* RenderWindow::loadTexture(const std::string &path) {
     return output;
 }
 
+bool RenderWindow::packAtlas(TextureAtlas &atlas) {
+    flushBatch();
+    return atlas.pack(Renderer);
+}
+
 void RenderWindow::renderTexture(SDL_Texture* texture, const SDL_Rect &src, const SDL_Rect &dst) {
+    flushBatch();
     const SDL_Rect destination = {W_2 + dst.x, H_2 - dst.y, dst.w, dst.h};
     SDL_RenderCopy(Renderer, texture, &src, &destination);
+    DrawCalls++;
 }
 void RenderWindow::renderTexture(SDL_Texture* texture, const SDL_Rect &src, const SDL_Rect &dst, const double &angle, const SDL_Point &center, const SDL_RendererFlip &flip) {
+    flushBatch();
     const SDL_Rect destination = {W_2 + dst.x, H_2 - dst.y, dst.w, dst.h};
     SDL_RenderCopyEx(Renderer, texture, &src, &destination, angle, &center, flip);
+    DrawCalls++;
 }
 void RenderWindow::renderTexture(const Texture &texture, const SDL_Rect &dst) {
+    if (texture.getAtlas() != NULL) {
+        queueSprite(texture, {W_2 + dst.x, H_2 - dst.y, dst.w, dst.h});
+        return;
+    }
+    flushBatch();
     const SDL_Rect source = texture.getFrame();
     const SDL_Rect destination = {W_2 + dst.x, H_2 - dst.y, dst.w, dst.h};
     const SDL_Point center = texture.getCenter();
     SDL_RenderCopyEx(Renderer, texture.getTexture(), &source, &destination, -texture.getAngle() * 180 / M_PI, &center, texture.getFlip());
+    DrawCalls++;
 }
 void RenderWindow::renderTexture(const Texture &texture, const SDL_Point &pos) {
+    if (texture.getAtlas() != NULL) {
+        queueSprite(texture, {W_2 + pos.x, H_2 - pos.y, texture.getFrame().w, texture.getFrame().h});
+        return;
+    }
+    flushBatch();
     const SDL_Rect src = texture.getFrame();
     const SDL_Rect dst = {W_2 + pos.x, H_2 - pos.y, texture.getFrame().w, texture.getFrame().h};
     const SDL_Point center = texture.getCenter();
     SDL_RenderCopyEx(Renderer, texture.getTexture(), &src, &dst, -texture.getAngle() * 180 / M_PI, &center, texture.getFlip());
+    DrawCalls++;
 }
 void RenderWindow::renderTexture(const Texture &texture, const int &x, const int &y) {
     const SDL_Point pos = {x, y};
     renderTexture(texture, pos);
 }
 
-void RenderWindow::renderText(TTF_Font *font, const char16_t* text, const SDL_Point &pos, const Uint32 wrapWidth, const SDL_Color &color) {
-    SDL_Surface *surface = TTF_RenderUNICODE_Blended_Wrapped(font, (Uint16*)text, color, wrapWidth);
-    renderTexture(SDL_CreateTextureFromSurface(Renderer, surface), {0, 0, surface->w, surface->h}, {pos.x - surface->w / 2, pos.y + surface->h / 2, surface->w, surface->h}, 0, {0, 0}, SDL_FLIP_NONE);
-    SDL_FreeSurface(surface);
-}
+void RenderWindow::renderHeightView(const HeightPyramid &pyramid, const std::vector<std::vector<double>> &grid, const double &row, const double &col, const double &zoom, const double &minVal, const double &maxVal, const SDL_Rect &dst, const unsigned char &mode) {
+    if (zoom <= 0.0 || dst.w <= 0 || dst.h <= 0 || pyramid.getW() == 0 || pyramid.getH() == 0) {return;}
+    flushBatch();
 
-void RenderWindow::drawLineOverlap(const int &x1, const int &y1, const int &x2, const int &y2, const unsigned char overlapType, const SDL_Color &color) {
-    if (x1 == x2 || y1 == y2) {
-        RenderWindow::fillRectangle(x1, x2, std::abs(x2 - x1), std::abs(y2 - y1), color);
-        return;
-    }
-    if (overlapType == LINE_OVERLAP_NONE) {
-        RenderWindow::drawLine(x1, y1, x2, y2, color);
-        return;
+    const int depth = pyramid.pickDepth(1.0 / zoom), span = 1 << depth;
+    const int firstCol = std::max((int)std::floor(col / span), 0), lastCol = std::min((int)std::ceil((col + dst.w / zoom) / span), pyramid.getW(depth));
+    const int firstRow = std::max((int)std::floor(row / span), 0), lastRow = std::min((int)std::ceil((row + dst.h / zoom) / span), pyramid.getH(depth));
+    if (firstCol >= lastCol || firstRow >= lastRow) {return;}
+    const SDL_Rect cells = {firstCol, firstRow, lastCol - firstCol, lastRow - firstRow};
+
+    if (ViewTexture == NULL || cells.w > ViewTextureW || cells.h > ViewTextureH) {
+        SDL_DestroyTexture(ViewTexture);
+        ViewTextureW = std::max(cells.w, ViewTextureW);
+        ViewTextureH = std::max(cells.h, ViewTextureH);
+        if ((ViewTexture = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, ViewTextureW, ViewTextureH)) == NULL) {
+            std::cout << "Failed to create height view texture\nERROR: " << SDL_GetError() << "\n";
+            ViewTextureW = 0;
+            ViewTextureH = 0;
+            return;
+        }
+        SDL_SetTextureScaleMode(ViewTexture, SDL_ScaleModeNearest);
+        ViewSource = NULL;
     }
-    int dx = x2 - x1, dy = y2 - y1;
-    int sx = 1, sy = 1;
 
-    if (dx < 0) {
-        dx = -dx;
-        sx = -1;
+    const bool sameCells = cells.x == ViewCells.x && cells.y == ViewCells.y && cells.w == ViewCells.w && cells.h == ViewCells.h;
+    const bool sameView = ViewSource == &pyramid && ViewDepth == depth && sameCells && ViewMin == minVal && ViewMax == maxVal && ViewMode == mode;
+    if (!sameView || ViewVersion != pyramid.getVersion()) {
+        // Edits only re-convert the visible rows they touched (plus a row either side, which shaded ramps read); anything else refills everything.
+        // Rows are converted whole since shading clamps at the ends of the span it is given
+        SDL_Rect area = {0, 0, cells.w, cells.h};
+        int firstRow, firstCol, lastRow, lastCol;
+        if (sameView && pyramid.getChanged(ViewVersion, firstRow, firstCol, lastRow, lastCol)) {
+            const int r0 = std::max((firstRow >> depth) - 1, cells.y), r1 = std::min((lastRow >> depth) + 1, cells.y + cells.h - 1);
+            area = {0, r0 - cells.y, cells.w, lastRow >= firstRow ? r1 - r0 + 1 : 0};
+        }
+
+        if (area.w > 0 && area.h > 0) {
+            void* pixels = NULL;
+            int pitch = 0;
+            if (SDL_LockTexture(ViewTexture, &area, &pixels, &pitch) != 0) {
+                std::cout << "Failed to lock height view texture\nERROR: " << SDL_GetError() << "\n";
+                return;
+            }
+            const int levelH = pyramid.getH(depth), x = cells.x;
+            for (int i = 0; i < area.h; i++) {
+                const int r = cells.y + area.y + i;
+                Uint32* dstRow = (Uint32*)((Uint8*)pixels + i * pitch);
+                if (depth == 0) {
+                    GridRamp.convert(r > 0 ? grid[r - 1].data() + x : NULL, grid[r].data() + x, r + 1 < levelH ? grid[r + 1].data() + x : NULL, area.w, minVal, maxVal, dstRow);
+                } else {
+                    const float* plane = pyramid.getValues(depth, mode).data() + x;
+                    const unsigned long int levelW = pyramid.getW(depth);
+                    GridRamp.convert(r > 0 ? plane + (r - 1) * levelW : NULL, plane + r * levelW, r + 1 < levelH ? plane + (r + 1) * levelW : NULL, area.w, minVal, maxVal, dstRow);
+                }
+            }
+            SDL_UnlockTexture(ViewTexture);
+        }
+
+        ViewSource = &pyramid;
+        ViewVersion = pyramid.getVersion();
+        ViewDepth = depth;
+        ViewCells = cells;
+        ViewMin = minVal;
+        ViewMax = maxVal;
+        ViewMode = mode;
     }
-    if (dy < 0) {
-        dy = -dy;
-        sy = -1;
+
+    // The outermost cells usually stick out of dst
+    setClip(dst.x, dst.y, dst.w, dst.h);
+    const SDL_Rect source = {0, 0, cells.w, cells.h};
+    const SDL_FRect destination = {(float)(W_2 + dst.x + (cells.x * span - col) * zoom), (float)(H_2 - dst.y + (cells.y * span - row) * zoom), (float)(cells.w * span * zoom), (float)(cells.h * span * zoom)};
+    SDL_RenderCopyF(Renderer, ViewTexture, &source, &destination);
+    DrawCalls++;
+    resetClip();
+}
+
+bool RenderWindow::visibleCells(const int &gridW, const int &gridH, const double &row, const double &col, const double &zoom, const SDL_Rect &dst, SDL_Rect &cells, int &step) const {
+    if (zoom <= 0.0 || dst.w <= 0 || dst.h <= 0 || gridW <= 0 || gridH <= 0) {return false;}
+    step = 1;
+    while (step * 2 * zoom <= 1.0 && step < std::max(gridW, gridH)) {step *= 2;}
+
+    const int firstCol = std::max((int)std::floor(col / step), 0), lastCol = std::min((int)std::ceil((col + dst.w / zoom) / step), (gridW + step - 1) / step);
+    const int firstRow = std::max((int)std::floor(row / step), 0), lastRow = std::min((int)std::ceil((row + dst.h / zoom) / step), (gridH + step - 1) / step);
+    cells = {firstCol, firstRow, lastCol - firstCol, lastRow - firstRow};
+    return cells.w > 0 && cells.h > 0;
+}
+bool RenderWindow::reserveOverlay(SDL_Texture* &texture, int &textureW, int &textureH, const int &w, const int &h, bool &recreated, const char* name) {
+    recreated = false;
+    if (texture != NULL && w <= textureW && h <= textureH) {return true;}
+
+    SDL_DestroyTexture(texture);
+    textureW = std::max(w, textureW);
+    textureH = std::max(h, textureH);
+    if ((texture = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, textureW, textureH)) == NULL) {
+        std::cout << "Failed to create " << name << " texture\nERROR: " << SDL_GetError() << "\n";
+        textureW = 0;
+        textureH = 0;
+        return false;
     }
-    int x = x1, y = y1, error = 0;
-    const int dx2 = dx * 2;
-    const int dy2 = dy * 2;
-
-    RenderWindow::drawPixel(x, y, color);
-    if (dx > dy) {
-        error = dy2 - dx;
-        while (x != x2) {
-            x += sx;
-            if (error >= 0) {
-                if (overlapType == LINE_OVERLAP_MAJOR || overlapType == LINE_OVERLAP_BOTH) {RenderWindow::drawPixel(x, y, color);}
-                y += sy;
-                if (overlapType == LINE_OVERLAP_MINOR || overlapType == LINE_OVERLAP_BOTH) {RenderWindow::drawPixel(x - sx, y, color);}
-                error -= dx2;
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(texture, SDL_ScaleModeNearest);
+    recreated = true;
+    return true;
+}
+void RenderWindow::drawOverlay(SDL_Texture* texture, const SDL_Rect &cells, const int &step, const double &row, const double &col, const double &zoom, const SDL_Rect &dst) {
+    setClip(dst.x, dst.y, dst.w, dst.h);
+    const SDL_Rect source = {0, 0, cells.w, cells.h};
+    const SDL_FRect destination = {(float)(W_2 + dst.x + (cells.x * step - col) * zoom), (float)(H_2 - dst.y + (cells.y * step - row) * zoom), (float)(cells.w * step * zoom), (float)(cells.h * step * zoom)};
+    SDL_RenderCopyF(Renderer, texture, &source, &destination);
+    DrawCalls++;
+    resetClip();
+}
+
+void RenderWindow::renderSearchHeat(const AStar_Recorder &recorder, const double &row, const double &col, const double &zoom, const SDL_Rect &dst, const Uint8 &opacity) {
+    SDL_Rect cells;
+    int step;
+    if (recorder.getCount() == 0 || !visibleCells(recorder.getW(), recorder.getH(), row, col, zoom, dst, cells, step)) {return;}
+    flushBatch();
+
+    bool recreated;
+    if (!reserveOverlay(HeatTexture, HeatTextureW, HeatTextureH, cells.w, cells.h, recreated, "search heat")) {return;}
+
+    const bool sameCells = cells.x == HeatCells.x && cells.y == HeatCells.y && cells.w == HeatCells.w && cells.h == HeatCells.h;
+    if (recreated || HeatSource != &recorder || HeatSerial != recorder.getSerial() || HeatCount != recorder.getCount() || !sameCells || HeatStep != step) {
+        const unsigned long int texels = (unsigned long int)cells.w * cells.h;
+        HeatOrder.assign(texels, 0);
+        HeatFirst.assign(texels, 0);
+        HeatRepeated.assign(texels, 0);
+        // Expansions are ranked across the whole search, but only the ones inside the view are kept
+        unsigned long int expanded = 0;
+        for (unsigned long int i = 0; i < recorder.getCount(); i++) {
+            const bool expand = recorder.getType(i) == ASTAR_EVENT_EXPAND;
+            if (expand) {expanded++;}
+            const std::pair<unsigned long int, unsigned long int> cell = recorder.getCell(i);
+            const long long r = (long long)(cell.first / step) - cells.y, c = (long long)(cell.second / step) - cells.x;
+            if (r < 0 || r >= cells.h || c < 0 || c >= cells.w) {continue;}
+
+            const unsigned long int t = r * cells.w + c, id = cell.first * recorder.getW() + cell.second;
+            if (expand && HeatOrder[t] == 0) {
+                HeatOrder[t] = expanded;
+                HeatFirst[t] = id;
+            } else if (!expand || HeatFirst[t] == id) {
+                HeatRepeated[t] = 1;
             }
-            error += dy2;
-            RenderWindow::drawPixel(x, y, color);
         }
-        return;
-    }
-    error = dx2 - dy;
-    while (y != y2) {
-        y += sy;
-        if (error >= 0) {
-            if (overlapType == LINE_OVERLAP_MAJOR || overlapType == LINE_OVERLAP_BOTH) {RenderWindow::drawPixel(x, y, color);}
-            x += sx;
-            if (overlapType == LINE_OVERLAP_MINOR || overlapType == LINE_OVERLAP_BOTH) {RenderWindow::drawPixel(x, y - sy, color);}
-            error -= dy2;
+
+        const SDL_Rect area = {0, 0, cells.w, cells.h};
+        void* pixels = NULL;
+        int pitch = 0;
+        if (SDL_LockTexture(HeatTexture, &area, &pixels, &pitch) != 0) {
+            std::cout << "Failed to lock search heat texture\nERROR: " << SDL_GetError() << "\n";
+            return;
+        }
+        const Uint32 white = Raster::pack(PresetColors[COLOR_WHITE]);
+        for (int i = 0; i < cells.h; i++) {
+            Uint32* dstRow = (Uint32*)((Uint8*)pixels + i * pitch);
+            for (int j = 0; j < cells.w; j++) {
+                const unsigned long int t = (unsigned long int)i * cells.w + j;
+                if (HeatRepeated[t]) {dstRow[j] = white;}
+                else if (HeatOrder[t] == 0) {dstRow[j] = 0;}
+                else {dstRow[j] = HeatRamp.getColor(expanded > 1 ? (HeatOrder[t] - 1) * 255 / (expanded - 1) : 0);}
+            }
         }
-        error += dx2;
-        RenderWindow::drawPixel(x, y, color);
+        SDL_UnlockTexture(HeatTexture);
+
+        HeatSource = &recorder;
+        HeatSerial = recorder.getSerial();
+        HeatCount = recorder.getCount();
+        HeatCells = cells;
+        HeatStep = step;
     }
+
+    SDL_SetTextureAlphaMod(HeatTexture, opacity);
+    drawOverlay(HeatTexture, cells, step, row, col, zoom, dst);
 }
 
-/**
- * Bresenham with thickness
- * No pixel missed and every pixel only drawn once!
- * The code is bigger and more complicated than drawThickLineSimple() but it tends to be faster, since drawing a pixel is often a slow operation.
- * aThicknessMode can be one of LINE_THICKNESS_MIDDLE, LINE_THICKNESS_DRAW_CLOCKWISE, LINE_THICKNESS_DRAW_COUNTERCLOCKWISE
- */
-void RenderWindow::drawThickLine(const int x1, const int y1, const int x2, const int y2, const int thickness, const unsigned char thicknessMode, const SDL_Color &color) {
-    if (thickness <= 1) {
-        RenderWindow::drawLine(x1, y1, x2, y2, color);
-        return;
+void RenderWindow::renderCellMask(const std::vector<unsigned char> &mask, const int &gridW, const int &gridH, const unsigned long int &serial, const double &row, const double &col, const double &zoom, const SDL_Rect &dst, const SDL_Color &color) {
+    SDL_Rect cells;
+    int step;
+    if (mask.size() != (unsigned long int)gridW * gridH || !visibleCells(gridW, gridH, row, col, zoom, dst, cells, step)) {return;}
+    flushBatch();
+
+    bool recreated;
+    if (!reserveOverlay(MaskTexture, MaskTextureW, MaskTextureH, cells.w, cells.h, recreated, "cell mask")) {return;}
+
+    const Uint32 tint = Raster::pack(color);
+    const bool sameCells = cells.x == MaskCells.x && cells.y == MaskCells.y && cells.w == MaskCells.w && cells.h == MaskCells.h;
+    if (recreated || MaskSource != mask.data() || MaskSerial != serial || !sameCells || MaskStep != step || MaskColor != tint) {
+        const SDL_Rect area = {0, 0, cells.w, cells.h};
+        void* pixels = NULL;
+        int pitch = 0;
+        if (SDL_LockTexture(MaskTexture, &area, &pixels, &pitch) != 0) {
+            std::cout << "Failed to lock cell mask texture\nERROR: " << SDL_GetError() << "\n";
+            return;
+        }
+        // Blocks of cells take the cell at their top-left corner
+        for (int i = 0; i < cells.h; i++) {
+            const unsigned char* src = mask.data() + (unsigned long int)(cells.y + i) * step * gridW + (unsigned long int)cells.x * step;
+            Uint32* dstRow = (Uint32*)((Uint8*)pixels + i * pitch);
+            for (int j = 0; j < cells.w; j++) {dstRow[j] = src[(unsigned long int)j * step] != 0 ? tint : 0;}
+        }
+        SDL_UnlockTexture(MaskTexture);
+
+        MaskSource = mask.data();
+        MaskSerial = serial;
+        MaskCells = cells;
+        MaskStep = step;
+        MaskColor = tint;
     }
-    int dx = x2 - x1, dy = y2 - y1;
-    int sx = 1, sy = 1;
-    bool swap = true;
-
-    if (dx < 0) {
-        dx = -dx;
-        sx = -1;
-        swap = !swap;
+
+    drawOverlay(MaskTexture, cells, step, row, col, zoom, dst);
+}
+
+void RenderWindow::setClip(const int &x, const int &y, const int &w, const int &h) {
+    flushBatch();
+    SDL_Rect area = {W_2 + x, H_2 - y, std::max(w, 0), std::max(h, 0)};
+    if (Repainting && ActiveLayer == -1 && !SDL_IntersectRect(&area, &RepaintClip, &area)) {area = {0, 0, 0, 0};}
+    SDL_RenderSetClipRect(Renderer, &area);
+}
+void RenderWindow::resetClip() {
+    flushBatch();
+    SDL_RenderSetClipRect(Renderer, Repainting && ActiveLayer == -1 ? &RepaintClip : NULL);
+}
+
+void RenderWindow::setGridRamp(const unsigned char &type) {
+    GridRamp = ColorRamp(type);
+    ViewSource = NULL;
+}
+unsigned char RenderWindow::getGridRamp() const {return GridRamp.getType();}
+
+bool RenderWindow::beginLayer(const int &id) {
+    flushBatch();
+    if (ActiveLayer != -1) {endLayer();}
+    Layer &layer = Layers[id];
+
+    int w = 0, h = 0;
+    if (layer.Target != NULL) {SDL_QueryTexture(layer.Target, NULL, NULL, &w, &h);}
+    if (layer.Target == NULL || w != W || h != H) {
+        SDL_DestroyTexture(layer.Target);
+        layer.Valid = false;
+        if ((layer.Target = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, W, H)) == NULL) {
+            // Without a texture the caller just draws the layer straight to the window every time
+            std::cout << "Failed to create layer texture\nERROR: " << SDL_GetError() << "\n";
+            return true;
+        }
+        SDL_SetTextureBlendMode(layer.Target, SDL_BLENDMODE_BLEND);
     }
-    if (dy < 0) {
-        dy = -dy;
-        sy = -1;
-        swap = !swap;
+    if (layer.Valid) {return false;}
+
+    if (SDL_SetRenderTarget(Renderer, layer.Target) != 0) {
+        std::cout << "Failed to draw to layer texture\nERROR: " << SDL_GetError() << "\n";
+        SDL_DestroyTexture(layer.Target);
+        layer.Target = NULL;
+        return true;
     }
+    SDL_SetRenderDrawColor(Renderer, 0, 0, 0, 0);
+    SDL_RenderClear(Renderer);
+    DrawCalls++;
+    ActiveLayer = id;
+    return true;
+}
+void RenderWindow::endLayer() {
+    if (ActiveLayer == -1) {return;}
+    flushBatch();
+    SDL_SetRenderTarget(Renderer, FrameTarget);
+    if (Repainting) {SDL_RenderSetClipRect(Renderer, &RepaintClip);}
+    Layers[ActiveLayer].Valid = true;
+    ActiveLayer = -1;
+}
+void RenderWindow::renderLayer(const int &id) {
+    const std::unordered_map<int, Layer>::const_iterator found = Layers.find(id);
+    if (found == Layers.end() || found->second.Target == NULL || !found->second.Valid) {return;}
+    flushBatch();
+    SDL_RenderCopy(Renderer, found->second.Target, NULL, NULL);
+    DrawCalls++;
+}
+void RenderWindow::invalidateLayer(const int &id) {
+    const std::unordered_map<int, Layer>::iterator found = Layers.find(id);
+    if (found != Layers.end()) {found->second.Valid = false;}
+    damageAll();
+}
+void RenderWindow::invalidateLayers() {
+    for (std::unordered_map<int, Layer>::iterator i = Layers.begin(); i != Layers.end(); i++) {i->second.Valid = false;}
+    damageAll();
+}
 
-    int xs = x1, xe = x2, ys = y1, ye = y2, error = 0;
-    const int dx2 = dx * 2;
-    const int dy2 = dy * 2;
-    unsigned char overlap;
+void RenderWindow::damage(const int &x, const int &y, const int &w, const int &h) {
+    const int x1 = std::max(W_2 + x, 0), y1 = std::max(H_2 - y, 0), x2 = std::min(W_2 + x + w, W), y2 = std::min(H_2 - y + h, H);
+    if (x1 >= x2 || y1 >= y2) {return;}
+    SDL_Rect area = {x1, y1, x2 - x1, y2 - y1};
 
-    int drawAdjust = thickness / 2;
-    if (thicknessMode == LINE_THICKNESS_DRAW_COUNTERCLOCKWISE) {
-        drawAdjust = thickness - 1;
-    } else if (thicknessMode == LINE_THICKNESS_DRAW_CLOCKWISE) {
-        drawAdjust = 0;
+    // Keep absorbing areas that overlap or touch this one until none are left
+    for (unsigned long int i = 0; i < Damage.size();) {
+        const SDL_Rect &other = Damage[i];
+        if (other.x > area.x + area.w || area.x > other.x + other.w || other.y > area.y + area.h || area.y > other.y + other.h) {
+            i++;
+            continue;
+        }
+        const int left = std::min(area.x, other.x), top = std::min(area.y, other.y);
+        area = {left, top, std::max(area.x + area.w, other.x + other.w) - left, std::max(area.y + area.h, other.y + other.h) - top};
+        Damage.erase(Damage.begin() + i);
+        i = 0;
     }
+    Damage.push_back(area);
 
-    if (dx >= dy) {
-        if (swap) {
-            drawAdjust = thickness - drawAdjust - 1;
-            sy = -sy;
-        } else {
-            sx = -sx;
+    if (Damage.size() > RENDER_DAMAGE_MAX_RECTS) {
+        SDL_Rect bounds = Damage[0];
+        for (unsigned long int i = 1; i < Damage.size(); i++) {
+            const int left = std::min(bounds.x, Damage[i].x), top = std::min(bounds.y, Damage[i].y);
+            bounds = {left, top, std::max(bounds.x + bounds.w, Damage[i].x + Damage[i].w) - left, std::max(bounds.y + bounds.h, Damage[i].y + Damage[i].h) - top};
         }
-        error = dy2 - dx;
-        for (int i = drawAdjust; i > 0; i--) {
-            xs -= sx;
-            xe -= sx;
-            if (error >= 0) {
-                ys -= sy;
-                ye -= sy;
-                error -= dx2;
-            }
-            error += dy2;
-        }
-        RenderWindow::drawLine(xs, ys, xe, ye, color);
-
-        error = dy2 - dx;
-        for (int i = thickness; i > 1; i--) {
-            xs += sx;
-            xe += sx;
-            overlap = LINE_OVERLAP_NONE;
-            if (error >= 0) {
-                ys += sy;
-                ye += sy;
-                error -= dx2;
-                overlap = LINE_OVERLAP_MAJOR;
-            }
-            error += dy2;
-            RenderWindow::drawLineOverlap(xs, ys, xe, ye, overlap, color);
-        }
-        return;
+        Damage.assign(1, bounds);
     }
+}
+void RenderWindow::damageAll() {Damage.assign(1, {0, 0, W, H});}
+bool RenderWindow::isDamaged() const {return !Damage.empty();}
 
-    if (swap) {
-        sx = -sx;
-    } else {
-        drawAdjust = thickness - drawAdjust - 1;
-        sy = -sy;
-    }
-    error = dx2 - dy;
-    for (int i = drawAdjust; i > 0; i--) {
-        ys -= sy;
-        ye -= sy;
-        if (error >= 0) {
-            xs -= sx;
-            xe -= sx;
-            error -= dy2;
+void RenderWindow::repaint(const std::function<void()> &draw) {
+    if (Damage.empty()) {return;}
+    flushBatch();
+
+    int w = 0, h = 0;
+    if (BackBuffer != NULL) {SDL_QueryTexture(BackBuffer, NULL, NULL, &w, &h);}
+    if (BackBuffer == NULL || w != W || h != H) {
+        SDL_DestroyTexture(BackBuffer);
+        if ((BackBuffer = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, W, H)) == NULL) {
+            // Fall back to redrawing the whole window every time
+            std::cout << "Failed to create back buffer\nERROR: " << SDL_GetError() << "\n";
+            Damage.clear();
+            draw();
+            show();
+            return;
         }
-        error += dx2;
+        damageAll();
     }
-    RenderWindow::drawLine(xs, ys, xe, ye, color);
-
-    error = dx2 - dy;
-    for (int i = thickness; i > 1; i--) {
-        ys += sy;
-        ye += sy;
-        overlap = LINE_OVERLAP_NONE;
-        if (error >= 0) {
-            xs += sx;
-            xe += sx;
-            error -= dy2;
-            overlap = LINE_OVERLAP_MAJOR;
-        }
-        error += dx2;
-        RenderWindow::drawLineOverlap(xs, ys, xe, ye, overlap, color);
+
+    // Copied so draw() can damage areas for the next frame without disturbing this one
+    const std::vector<SDL_Rect> areas = Damage;
+    Damage.clear();
+
+    SDL_SetRenderTarget(Renderer, BackBuffer);
+    FrameTarget = BackBuffer;
+    Repainting = true;
+    for (unsigned long int i = 0; i < areas.size(); i++) {
+        RepaintClip = areas[i];
+        SDL_RenderSetClipRect(Renderer, &RepaintClip);
+        draw();
+        endLayer();
+        flushBatch();
     }
+    Repainting = false;
+    SDL_RenderSetClipRect(Renderer, NULL);
+    SDL_SetRenderTarget(Renderer, NULL);
+    FrameTarget = NULL;
+
+    SDL_RenderCopy(Renderer, BackBuffer, NULL, NULL);
+    DrawCalls++;
+    show();
+}
+
+void RenderWindow::renderText(TTF_Font *font, const char16_t* text, const SDL_Point &pos, const Uint32 wrapWidth, const SDL_Color &color) {
+    if (font == NULL || text == NULL) {return;}
+    std::unique_ptr<GlyphAtlas> &atlas = Atlases[font];
+    if (!atlas) {atlas.reset(new GlyphAtlas(Renderer, font));}
+
+    const GlyphAtlas::Layout &layout = atlas->layout(text, wrapWidth);
+    queueGeometry(atlas->getTexture(), layout.Vertices, layout.Indices, W_2 + pos.x - layout.W / 2, H_2 - pos.y - layout.H / 2, color);
+}
+void RenderWindow::releaseFont(TTF_Font *font) {
+    flushBatch();
+    Atlases.erase(font);
 }
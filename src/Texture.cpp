@@ -1,14 +1,21 @@
+#include <cmath>
+
 #include "Texture.hpp"
 
 Texture::Texture() : Source(NULL), Center({}), Frame({}) {}
 Texture::Texture(SDL_Texture* texture) : Source(texture), Center({}), Frame({}) {}
 Texture::Texture(SDL_Texture* texture, SDL_Point center, SDL_Rect frame) : Source(texture), Center(center), Frame(frame) {}
 Texture::Texture(SDL_Texture* texture, SDL_Rect frame) : Source(texture), Center({frame.w / 2, frame.h / 2}), Frame(frame) {}
+Texture::Texture(const TextureAtlas &atlas, const std::string &name) : Atlas(&atlas), Frame(atlas.getFrame(name)) {Center = {Frame.w / 2, Frame.h / 2};}
+Texture::Texture(const TextureAtlas &atlas, const std::string &name, SDL_Point center) : Atlas(&atlas), Center(center), Frame(atlas.getFrame(name)) {}
 
-SDL_Texture* Texture::getTexture() const {return Source;}
+SDL_Texture* Texture::getTexture() const {return Atlas != NULL ? Atlas->getTexture() : Source;}
+const TextureAtlas* Texture::getAtlas() const {return Atlas;}
 SDL_Point Texture::getCenter() const {return Center;}
 SDL_Rect Texture::getFrame() const {return Frame;}
 double Texture::getAngle() const {return Angle;}
+double Texture::getAngleCos() const {return AngleCos;}
+double Texture::getAngleSin() const {return AngleSin;}
 SDL_RendererFlip Texture::getFlip() const {return Flip;}
 
 SDL_BlendMode Texture::getBlending() const {return BlendMode;}
@@ -39,6 +46,8 @@ SDL_Rect Texture::setFrame(SDL_Rect frame) {
 double Texture::setAngle(double angle) {
     double output = Angle;
     Angle = angle;
+    AngleCos = std::cos(Angle);
+    AngleSin = std::sin(Angle);
     return output;
 }
 SDL_RendererFlip Texture::setFlip(SDL_RendererFlip flip) {
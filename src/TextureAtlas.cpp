@@ -0,0 +1,102 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+#include "TextureAtlas.hpp"
+
+TextureAtlas::~TextureAtlas() {
+    for (unsigned long int i = 0; i < Images.size(); i++) {SDL_FreeSurface(Images[i].Pixels);}
+    SDL_DestroyTexture(Source);
+}
+
+bool TextureAtlas::add(const std::string &name, const std::string &path) {
+    SDL_Surface* loaded = IMG_Load(path.c_str());
+    if (loaded == NULL) {
+        std::cout << "Failed to load atlas image\nERROR: " << IMG_GetError() << "\n";
+        return false;
+    }
+    SDL_Surface* pixels = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(loaded);
+    if (pixels == NULL) {
+        std::cout << "Failed to convert atlas image\nERROR: " << SDL_GetError() << "\n";
+        return false;
+    }
+
+    for (unsigned long int i = 0; i < Images.size(); i++) {
+        if (Images[i].Name == name) {
+            SDL_FreeSurface(Images[i].Pixels);
+            Images[i].Pixels = pixels;
+            return true;
+        }
+    }
+    Images.push_back({name, pixels});
+    return true;
+}
+
+bool TextureAtlas::pack(SDL_Renderer* renderer) {
+    // Tallest first keeps the rows tight
+    std::vector<unsigned long int> order(Images.size());
+    for (unsigned long int i = 0; i < order.size(); i++) {order[i] = i;}
+    std::sort(order.begin(), order.end(), [&](const unsigned long int &a, const unsigned long int &b) {return Images[a].Pixels->h > Images[b].Pixels->h;});
+
+    int widest = 1;
+    double area = 0.0;
+    for (unsigned long int i = 0; i < Images.size(); i++) {
+        widest = std::max(widest, Images[i].Pixels->w + 1);
+        area += (double)(Images[i].Pixels->w + 1) * (Images[i].Pixels->h + 1);
+    }
+    int w = 1;
+    while (w < widest || w < std::sqrt(area)) {w *= 2;}
+
+    std::unordered_map<std::string, SDL_Rect> frames;
+    int penX = 0, penY = 0, rowH = 0;
+    for (unsigned long int i = 0; i < order.size(); i++) {
+        const Image &image = Images[order[i]];
+        if (penX + image.Pixels->w > w) {
+            penX = 0;
+            penY += rowH + 1;
+            rowH = 0;
+        }
+        frames[image.Name] = {penX, penY, image.Pixels->w, image.Pixels->h};
+        penX += image.Pixels->w + 1;
+        rowH = std::max(rowH, image.Pixels->h);
+    }
+    int h = 1;
+    while (h < penY + rowH) {h *= 2;}
+
+    SDL_Surface* pixels = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (pixels == NULL) {
+        std::cout << "Failed to create texture atlas\nERROR: " << SDL_GetError() << "\n";
+        return false;
+    }
+    SDL_FillRect(pixels, NULL, 0);
+    for (unsigned long int i = 0; i < Images.size(); i++) {
+        SDL_Rect frame = frames[Images[i].Name];
+        SDL_SetSurfaceBlendMode(Images[i].Pixels, SDL_BLENDMODE_NONE);
+        SDL_BlitSurface(Images[i].Pixels, NULL, pixels, &frame);
+    }
+
+    SDL_Texture* source = SDL_CreateTextureFromSurface(renderer, pixels);
+    SDL_FreeSurface(pixels);
+    if (source == NULL) {
+        std::cout << "Failed to create texture atlas texture\nERROR: " << SDL_GetError() << "\n";
+        return false;
+    }
+    SDL_SetTextureBlendMode(source, SDL_BLENDMODE_BLEND);
+
+    SDL_DestroyTexture(Source);
+    Source = source;
+    Frames.swap(frames);
+    W = w;
+    H = h;
+    return true;
+}
+
+SDL_Texture* TextureAtlas::getTexture() const {return Source;}
+int TextureAtlas::getW() const {return W;}
+int TextureAtlas::getH() const {return H;}
+bool TextureAtlas::has(const std::string &name) const {return Frames.find(name) != Frames.end();}
+SDL_Rect TextureAtlas::getFrame(const std::string &name) const {
+    const std::unordered_map<std::string, SDL_Rect>::const_iterator found = Frames.find(name);
+    return found != Frames.end() ? found->second : SDL_Rect{0, 0, 0, 0};
+}
@@ -4,40 +4,25 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <cmath>
+#include <memory>
 
 #include "RenderWindow.hpp"
 #include "Utilities.hpp"
 #include "AStar.hpp"
+#include "ProgressiveNoise.hpp"
+#include "NoiseChunks.hpp"
+#include "HeightPyramid.hpp"
+#include "Brush.hpp"
+#include "EditHistory.hpp"
+#include "RegionFill.hpp"
+#include "Resample.hpp"
+#include "MapFile.hpp"
+#include "HeightmapImage.hpp"
 
 #include "CursorBox.hpp"
 
-std::vector<std::vector<double>> brushGrid(const std::vector<std::vector<double>> &grid, const int &row, const int &col, const double &strength, const int &radius, const double &maxVal, const double &minVal = 0.0) {
-    if (row < 0 || row >= (int)grid.size() || col < 0 || col >= (int)grid.at(row).size()) {return grid;}
-    std::vector<std::vector<double>> output = grid;
-    for (int i = 0; i < radius; i++) {
-        for (int j = radius - i; j < radius + i + 1; j++) {
-            const int rowT = row - radius + i, rowB = row + radius - i, c = col - radius + j;
-            if (rowT >= 0 && c >= 0 && c < (int)grid.at(i).size()) {
-                output[rowT][c] += strength;
-                if (output[rowT][c] > maxVal) {output[rowT][c] = maxVal;}
-                else if (output[rowT][c] < minVal) {output[rowT][c] = minVal;}
-            }
-            if (rowB < (int)grid.size() && c >= 0 && c < (int)grid.at(i).size()) {
-                output[rowB][c] += strength;
-                if (output[rowB][c] > maxVal) {output[rowB][c] = maxVal;}
-                else if (output[rowB][c] < minVal) {output[rowB][c] = minVal;}
-            }
-        }
-    }
-    for (int i = col - radius; i < col + radius + 1; i++) {
-        if (i >= 0 && i < (int)grid.at(row).size()) {
-            output[row][i] += strength;
-            if (output[row][i] > maxVal) {output[row][i] = maxVal;}
-            else if (output[row][i] < minVal) {output[row][i] = minVal;}
-        }
-    }
-    return output;
-}
+#define UI_LAYER_STATIC 0    // Background, frames, button outlines & labels that never change
 
 double HireTime_Sec() {return SDL_GetTicks() * 0.01f;}
 int main(int argc, char* args[]) {
@@ -51,11 +36,17 @@ int main(int argc, char* args[]) {
 
     TTF_Font *font = TTF_OpenFont("dev/fonts/GNU-Unifont.ttf", 30);
 
-    Texture tile(Window.loadTexture("dev/png/tile.png"), {32, 32}, {0, 0, 64, 64});
+    // Every sprite comes from one atlas so the background & buttons each take a single draw call
+    TextureAtlas sprites;
+    sprites.add("tile", "dev/png/tile.png");
+    sprites.add("btn_arrow", "dev/png/btn_arrow.png");
+    Window.packAtlas(sprites);
+
+    Texture tile(sprites, "tile", {32, 32});
     tile.setMods({64, 64, 64, 255});
     const int tileSize = 64;
 
-    Texture arrowButton(Window.loadTexture("dev/png/btn_arrow.png"), {16, 16}, {0, 0, 32, 32});
+    Texture arrowButton(sprites, "btn_arrow", {16, 16});
 
     MouseState mstate;
 
@@ -68,6 +59,33 @@ int main(int argc, char* args[]) {
         int ClearMaze = SDL_SCANCODE_C;
         int HardBrush = SDL_SCANCODE_S;
         int HardErase = SDL_SCANCODE_D;
+        int GenerateTerrain = SDL_SCANCODE_G;
+        int ResetView = SDL_SCANCODE_V;
+        int CycleRamp = SDL_SCANCODE_R;
+        // Shows the cells of freshly generated terrain too steep to climb straight up
+        int ToggleSteep = SDL_SCANCODE_P;
+#if ASTAR_RECORD
+        int ToggleHeat = SDL_SCANCODE_H;
+#endif
+        // Both with Ctrl held
+        int Undo = SDL_SCANCODE_Z;
+        int Redo = SDL_SCANCODE_Y;
+        int CycleBrushShape = SDL_SCANCODE_B;
+        int CycleBrushMode = SDL_SCANCODE_M;
+        // Raise the region under the cursor by the brush strength (Shift lowers it, Ctrl flattens it to the cell's height)
+        int FillTolerance = SDL_SCANCODE_F;
+        int FillReachable = SDL_SCANCODE_E;
+        // Save writes 32-bit floats, or 16-bit values with Shift held
+        int SaveMap = SDL_SCANCODE_F5;
+        int LoadMap = SDL_SCANCODE_F9;
+        // 16-bit greyscale PNG/PGM heightmaps, spanning the minimum to the maximum cell value
+        int ExportImage = SDL_SCANCODE_F6;
+        int ImportImage = SDL_SCANCODE_F10;
+        // Move the map half its size across the endless terrain
+        int WorldUp = SDL_SCANCODE_UP;
+        int WorldDown = SDL_SCANCODE_DOWN;
+        int WorldLeft = SDL_SCANCODE_LEFT;
+        int WorldRight = SDL_SCANCODE_RIGHT;
     } Keybinds;
 
     long double t = 0.0;
@@ -86,6 +104,12 @@ int main(int argc, char* args[]) {
         int Radius = 5;
         int RadiusMax = 50;
         int RadiusMin = 0;
+        Brush Engine;
+        // Amount the stroke in progress adds per application
+        double StrokeStrength = 0.0;
+        RegionFill Region;
+        // Largest height difference from the clicked cell a tolerance fill takes in
+        double FillTolerance = 2.0;
     } Tool;
     struct {
         std::vector<std::vector<double>> Grid;
@@ -98,13 +122,52 @@ int main(int argc, char* args[]) {
         double MinVal = 0.0;
         
         std::pair<unsigned long int, unsigned long int> Start = std::make_pair(0, 0), Goal = std::make_pair(Dims.y - 1, Dims.x - 1);
-        SDL_Point Pos = {0, 0}, PrevPos = Pos;
+        SDL_Point Pos = {0, 0};
         SDL_Point Offset = {72, 40};
+
+        // Mipmaps the view is drawn from, kept up to date with every edit
+        HeightPyramid Pyramid;
+        // Undo & redo for brush strokes & grid resets; forgotten whenever the grid is replaced
+        EditHistory History;
+        // Heightmap cell at the top-left corner of the map and pixels per cell; the wheel zooms and the middle button pans
+        double ViewRow = 0.0, ViewCol = 0.0;
+        double Zoom = CellSizes[SizeIndex];
+        double ZoomMin = 1.0 / 64.0, ZoomMax = 144.0;
+        // Where the map is saved to & loaded from; the first command line argument replaces it (and is loaded on startup)
+        std::string File = "map.tbm";
+        // Where heightmap images are exported to & imported from; replaced by the first command line argument instead if that is a .png or .pgm
+        std::string Image = "heightmap.png";
     } Map;
     struct {
         std::vector<std::pair<unsigned long int, unsigned long int>> Nodes;
         double MaxUp = 5.0, MaxDown = 10.0;
+        // Steepest climb out of each cell of the last generated terrain in height per cell, from the noise's analytic gradient; only valid while the pyramid is still at SlopeVersion
+        std::vector<float> Slope;
+        unsigned long int SlopeVersion = 0;
+        // Cells whose slope is more than MaxUp, drawn over the map while ShowSteep is on
+        std::vector<unsigned char> Steep;
+        unsigned long int SteepSerial = 0;
+        bool ShowSteep = false;
+#if ASTAR_RECORD
+        // What the last search expanded, drawn over the map while ShowHeat is on
+        AStar_Recorder Recorder;
+        bool ShowHeat = false;
+#endif
     } Pathfinder;
+#if ASTAR_RECORD
+    AStar.setRecorder(&Pathfinder.Recorder);
+#endif
+    struct {
+        ProgressiveNoise Generator;
+        int Octaves = 6;
+        double Bias = 2.0;
+        double Scale = 48.0;
+        long long Seed = 0;
+        // World cell at the map's top-left corner; each seed is its own stretch of the same endless terrain
+        long long WorldRow = 0, WorldCol = 0;
+        // Chunks of that terrain the map is streamed from when it moves; remade whenever the settings change
+        std::unique_ptr<NoiseChunks> World;
+    } Terrain;
 
     for (int i = 0; i < Map.Dims.y; i++) {
         Map.Grid.emplace_back();
@@ -112,6 +175,151 @@ int main(int argc, char* args[]) {
             Map.Grid[i].emplace_back(Map.MinVal);
         }
     }
+    Map.Pyramid.build(Map.Grid);
+
+    // Repaint helpers; everything drawn inside a damaged area is redrawn, so these only have to cover what changed
+    const auto viewX = [&](const double &col) {return -Window.getW_2() + Map.Offset.x + (int)std::floor((col - Map.ViewCol) * Map.Zoom);};
+    const auto viewY = [&](const double &row) {return Window.getH_2() - Map.Offset.y - (int)std::floor((row - Map.ViewRow) * Map.Zoom);};
+    const auto damageCells = [&](const int &firstRow, const int &firstCol, const int &lastRow, const int &lastCol) {
+        const int x = viewX(firstCol), y = viewY(firstRow);
+        Window.damage(x, y, viewX(lastCol + 1) - x + 1, y - viewY(lastRow + 1) + 1);
+    };
+    Tool.Engine.setBeforeChange([&](const Brush::Area &area) {Map.History.capture(Map.Grid, area);});
+    // Strokes follow every mouse sample and are applied once a frame (and when they end), then the pyramid & screen are updated only where cells changed
+    const auto beginStroke = [&](const double &strength) {
+        Tool.Engine.beginStroke(Map.Pos.y, Map.Pos.x);
+        // Filtering brushes blend towards their target by a fraction instead, so either button does the same thing
+        Tool.StrokeStrength = Tool.Engine.getMode() == BRUSH_MODE_RAISE ? strength : std::min(std::fabs(strength) / Tool.StrengthMax, 1.0);
+    };
+    const auto applyStroke = [&]() {
+        const std::vector<Brush::Area> &areas = Tool.Engine.applyStroke(Map.Grid, Tool.StrokeStrength, Tool.Radius, Map.MinVal, Map.MaxVal);
+        for (unsigned long int i = 0; i < areas.size(); i++) {
+            Map.Pyramid.update(Map.Grid, areas[i].FirstRow, areas[i].FirstCol, areas[i].LastRow, areas[i].LastCol);
+            damageCells(areas[i].FirstRow, areas[i].FirstCol, areas[i].LastRow, areas[i].LastCol);
+        }
+    };
+    // A finished stroke becomes one undo step
+    const auto endStroke = [&]() {
+        applyStroke();
+        Tool.Engine.endStroke();
+        Map.History.commit(Map.Grid);
+    };
+    const auto stepHistory = [&](const bool &forward) {
+        if (Tool.Engine.isStroking()) {endStroke();}
+        const Brush::Area area = forward ? Map.History.redo(Map.Grid) : Map.History.undo(Map.Grid);
+        if (area.isEmpty()) {return;}
+        Map.Pyramid.update(Map.Grid, area.FirstRow, area.FirstCol, area.LastRow, area.LastCol);
+        damageCells(area.FirstRow, area.FirstCol, area.LastRow, area.LastCol);
+        std::cout << (forward ? "[Grid] Redid edit\n" : "[Grid] Undid edit\n");
+    };
+    // Region fills are one undo step each, taken either within a height tolerance or as far as a path could walk with the current mobility
+    const auto fillRegion = [&](const unsigned char &rule, const Uint16 &mods) {
+        if (Tool.Engine.isStroking()) {endStroke();}
+        const Uint64 startCount = SDL_GetPerformanceCounter();
+        if (Tool.Region.select(Map.Grid, Map.Pos.y, Map.Pos.x, rule, Tool.FillTolerance, Pathfinder.MaxUp, Pathfinder.MaxDown) == 0) {return;}
+
+        const Brush::Area bounds = Tool.Region.getBounds();
+        Map.History.capture(Map.Grid, bounds);
+        const Brush::Area area = (mods & KMOD_CTRL) ? Tool.Region.apply(Map.Grid, REGION_SET, Map.Grid[Map.Pos.y][Map.Pos.x], Map.MinVal, Map.MaxVal) : Tool.Region.apply(Map.Grid, REGION_RAISE, (mods & KMOD_SHIFT) ? -Tool.Strength : Tool.Strength, Map.MinVal, Map.MaxVal);
+        Map.History.commit(Map.Grid);
+        Map.Pyramid.update(Map.Grid, area.FirstRow, area.FirstCol, area.LastRow, area.LastCol);
+        damageCells(area.FirstRow, area.FirstCol, area.LastRow, area.LastCol);
+        std::cout << "[Grid] Filled " << Tool.Region.getCells() << " cells in " << (SDL_GetPerformanceCounter() - startCount) * 1000.0 / SDL_GetPerformanceFrequency() << " ms\n";
+    };
+    const auto damageMap = [&]() {Window.damage(-Window.getW_2() + Map.Offset.x, Window.getH_2() - Map.Offset.y, 720, 576);};
+    const auto damagePath = [&]() {
+        int firstRow = std::min(Map.Start.first, Map.Goal.first), lastRow = std::max(Map.Start.first, Map.Goal.first);
+        int firstCol = std::min(Map.Start.second, Map.Goal.second), lastCol = std::max(Map.Start.second, Map.Goal.second);
+        for (unsigned long int i = 0; i < Pathfinder.Nodes.size(); i++) {
+            firstRow = std::min(firstRow, (int)Pathfinder.Nodes[i].first);
+            lastRow = std::max(lastRow, (int)Pathfinder.Nodes[i].first);
+            firstCol = std::min(firstCol, (int)Pathfinder.Nodes[i].second);
+            lastCol = std::max(lastCol, (int)Pathfinder.Nodes[i].second);
+        }
+        damageCells(firstRow, firstCol, lastRow, lastCol);
+    };
+    const auto saveMap = [&](const unsigned char &type) {
+        if (Tool.Engine.isStroking()) {endStroke();}
+        if (MapFile::save(Map.File, Map.Grid, type, Map.MinVal, Map.MaxVal)) {std::cout << "[Grid] Saved map to " << Map.File << "\n";}
+    };
+    const auto markSteep = [&]() {
+        Pathfinder.Steep.resize(Pathfinder.Slope.size());
+        for (unsigned long int i = 0; i < Pathfinder.Slope.size(); i++) {Pathfinder.Steep[i] = Pathfinder.Slope[i] > Pathfinder.MaxUp;}
+        Pathfinder.SteepSerial++;
+        if (Pathfinder.ShowSteep) {damageMap();}
+    };
+    // Catch everything up with a grid that was replaced outright, whatever size it now is
+    const auto adoptGrid = [&]() {
+        Map.Dims = {(int)Map.Grid[0].size(), (int)Map.Grid.size()};
+        Map.Start = std::make_pair(0, 0);
+        Map.Goal = std::make_pair(Map.Dims.y - 1, Map.Dims.x - 1);
+        Map.Pyramid.build(Map.Grid);
+        Map.History.clear();
+        Map.Zoom = btils::clamp<double>(std::min(720.0 / Map.Dims.x, 576.0 / Map.Dims.y), Map.ZoomMin, Map.ZoomMax);
+        Map.ViewRow = 0.0;
+        Map.ViewCol = 0.0;
+        Pathfinder.Nodes.clear();
+        damageMap();
+    };
+    // Loaded maps replace the grid, taking their size & height range with them
+    const auto loadMap = [&]() {
+        MapFile file;
+        if (!file.open(Map.File) || !file.verify()) {return;}
+        if (Tool.Engine.isStroking()) {endStroke();}
+        Terrain.Generator.cancel();
+
+        file.read(Map.Grid);
+        Map.MinVal = file.getHeader().MinVal;
+        Map.MaxVal = file.getHeader().MaxVal;
+        adoptGrid();
+        std::cout << "[Grid] Loaded map from " << Map.File << " (" << Map.Dims.x << " x " << Map.Dims.y << ")\n";
+    };
+    const auto exportImage = [&]() {
+        if (Tool.Engine.isStroking()) {endStroke();}
+        if (exportHeightmap(Map.Image, Map.Grid, Map.MinVal, Map.MaxVal)) {std::cout << "[Grid] Exported heightmap to " << Map.Image << "\n";}
+    };
+    // Imported images replace the grid only once they have been read in full, so a failed import leaves the map as it was
+    const auto importImage = [&]() {
+        if (Tool.Engine.isStroking()) {endStroke();}
+        if (!importHeightmap(Map.Image, Map.Grid, Map.MinVal, Map.MaxVal)) {return;}
+        Terrain.Generator.cancel();
+
+        adoptGrid();
+        std::cout << "[Grid] Imported heightmap from " << Map.Image << " (" << Map.Dims.x << " x " << Map.Dims.y << ")\n";
+    };
+    // Moving the map replaces the grid with the next stretch of terrain (edits don't travel with it); the stretch beyond that is prefetched in the background
+    const auto moveWorld = [&](const int &rows, const int &cols) {
+        if (Tool.Engine.isStroking()) {endStroke();}
+        Terrain.Generator.cancel();
+        // Room for the map & a ring of chunks around it, four times over
+        const unsigned long int across = (Map.Dims.x + NOISE_CHUNK_SIZE - 1) / NOISE_CHUNK_SIZE + 2, down = (Map.Dims.y + NOISE_CHUNK_SIZE - 1) / NOISE_CHUNK_SIZE + 2;
+        if (!Terrain.World || Terrain.World->getCapacity() < across * down * 4 || Terrain.World->getOctaves() != Terrain.Octaves || Terrain.World->getBias() != Terrain.Bias || Terrain.World->getScale() != Terrain.Scale) {
+            Terrain.World.reset(new NoiseChunks(NOISE_CHUNK_SIZE, across * down * 4, Terrain.Octaves, Terrain.Bias, Terrain.Scale));
+        }
+
+        Terrain.WorldRow += rows;
+        Terrain.WorldCol += cols;
+        const long long row = Terrain.Seed * 100003 + Terrain.WorldRow;
+        Terrain.World->readRegion(row, Terrain.WorldCol, Map.Grid, Map.MinVal, Map.MaxVal);
+        Terrain.World->prefetchRegion(row + rows, Terrain.WorldCol + cols, Map.Dims.x, Map.Dims.y);
+
+        Map.Pyramid.build(Map.Grid);
+        Map.History.clear();
+        Pathfinder.Nodes.clear();
+        damageMap();
+        std::cout << "[Grid] Moved to " << Terrain.WorldCol << ", " << Terrain.WorldRow << "\n";
+    };
+    if (argc > 1) {
+        if (isHeightmapImage(args[1])) {
+            Map.Image = args[1];
+            importImage();
+        } else {
+            Map.File = args[1];
+            loadMap();
+        }
+    }
+    // Vertical centers of the setting value labels, in the same order as the increment buttons (two per label)
+    const int valueLabels[7] = {232, 165, 48, -20, -87, -204, -271};
 
     CursorBox map({Map.Offset.x, Map.Offset.y, 720, 576}), genPath({8, 655, 209, 45}), placeStart({225, 655, 209, 45}), placeGoal({442, 655, 209, 45}), gridReset({659, 655, 209, 45});
     CursorBox increments[14] = {
@@ -126,7 +334,7 @@ int main(int argc, char* args[]) {
 
     int drawMode = 0;
 
-    bool running = true, madeChanges = true;
+    bool running = true;
     while (running) {
         startTicks = SDL_GetTicks();
         newTime = HireTime_Sec();
@@ -154,7 +362,13 @@ int main(int argc, char* args[]) {
                             mstate.Rel = {0, 0};
                         }
 
-                        Map.Pos = {(mstate.PosR.x - Map.Offset.x) / Map.CellSizes[Map.SizeIndex], (mstate.PosR.y - Map.Offset.y) / Map.CellSizes[Map.SizeIndex]};
+                        if (mstate.Pressed[SDL_BUTTON_MIDDLE]) {
+                            Map.ViewCol -= Event.motion.xrel / Map.Zoom;
+                            Map.ViewRow -= Event.motion.yrel / Map.Zoom;
+                            damageMap();
+                        }
+                        Map.Pos = {(int)std::floor(Map.ViewCol + (mstate.PosR.x - Map.Offset.x) / Map.Zoom), (int)std::floor(Map.ViewRow + (mstate.PosR.y - Map.Offset.y) / Map.Zoom)};
+                        Tool.Engine.addSample(Map.Pos.y, Map.Pos.x);
                         break;
                     case SDL_KEYDOWN:
                         if (!Event.key.repeat) {
@@ -171,34 +385,98 @@ int main(int argc, char* args[]) {
                                     mstate.PosR = {0, 0};
                                 }
                             }
+                            if (Keystate[Keybinds.GenerateTerrain]) {
+                                Terrain.Seed++;
+                                Terrain.Generator.start(Map.Dims.x, Map.Dims.y, Terrain.Octaves, Terrain.Bias, Terrain.Scale, PERLIN_INTERP_QUINTIC, NOISE_KERNEL_PERLIN, 8, Terrain.Seed * 100003 + Terrain.WorldRow, Terrain.WorldCol, 0, true);
+                                std::cout << "[Grid] Generating terrain (seed " << Terrain.Seed << ")\n";
+                            }
+                            if (Keystate[Keybinds.ResetView]) {
+                                Map.Zoom = Map.CellSizes[Map.SizeIndex];
+                                Map.ViewRow = 0.0;
+                                Map.ViewCol = 0.0;
+                                damageMap();
+                            }
+                            if (Keystate[Keybinds.CycleRamp]) {
+                                Window.setGridRamp((Window.getGridRamp() + 1) % 3);
+                                damageMap();
+                            }
+                            if (Keystate[Keybinds.HardBrush]) {beginStroke(Map.MaxVal);}
+                            if (Keystate[Keybinds.HardErase]) {beginStroke(-Map.MaxVal);}
+                            if (Keystate[Keybinds.Undo] && (Event.key.keysym.mod & KMOD_CTRL)) {stepHistory(false);}
+                            if (Keystate[Keybinds.Redo] && (Event.key.keysym.mod & KMOD_CTRL)) {stepHistory(true);}
+                            if (Keystate[Keybinds.CycleBrushShape]) {
+                                const char* names[3] = {"diamond", "gaussian", "cosine"};
+                                Tool.Engine.setShape((Tool.Engine.getShape() + 1) % 3);
+                                std::cout << "[Tool] Brush shape - now " << names[Tool.Engine.getShape()] << "\n";
+                            }
+                            if (Keystate[Keybinds.CycleBrushMode] && !Tool.Engine.isStroking()) {
+                                const char* names[4] = {"raise", "smooth", "sharpen", "erode"};
+                                Tool.Engine.setMode((Tool.Engine.getMode() + 1) % 4);
+                                std::cout << "[Tool] Brush mode - now " << names[Tool.Engine.getMode()] << "\n";
+                            }
+                            if (Keystate[Keybinds.FillTolerance]) {fillRegion(REGION_TOLERANCE, Event.key.keysym.mod);}
+                            if (Keystate[Keybinds.FillReachable]) {fillRegion(REGION_REACHABLE, Event.key.keysym.mod);}
+                            if (Keystate[Keybinds.SaveMap]) {saveMap((Event.key.keysym.mod & KMOD_SHIFT) ? MAPFILE_UINT16 : MAPFILE_FLOAT32);}
+                            if (Keystate[Keybinds.LoadMap]) {loadMap();}
+                            if (Keystate[Keybinds.ExportImage]) {exportImage();}
+                            if (Keystate[Keybinds.ImportImage]) {importImage();}
+                            if (Keystate[Keybinds.WorldUp]) {moveWorld(-Map.Dims.y / 2, 0);}
+                            if (Keystate[Keybinds.WorldDown]) {moveWorld(Map.Dims.y / 2, 0);}
+                            if (Keystate[Keybinds.WorldLeft]) {moveWorld(0, -Map.Dims.x / 2);}
+                            if (Keystate[Keybinds.WorldRight]) {moveWorld(0, Map.Dims.x / 2);}
+                            if (Keystate[Keybinds.ToggleSteep]) {
+                                Pathfinder.ShowSteep = !Pathfinder.ShowSteep;
+                                damageMap();
+                            }
+#if ASTAR_RECORD
+                            if (Keystate[Keybinds.ToggleHeat]) {
+                                Pathfinder.ShowHeat = !Pathfinder.ShowHeat;
+                                damageMap();
+                            }
+#endif
                         }
                         break;
                     case SDL_WINDOWEVENT:
                         Window.handleEvent(Event.window);
                         break;
+                    case SDL_RENDER_TARGETS_RESET:
+                        // Some backends throw away the contents of target textures
+                        Window.invalidateLayers();
+                        break;
                     case SDL_MOUSEBUTTONDOWN:
                         mstate.Pressed[Event.button.button] = true;
                         switch (Event.button.button) {
                             case SDL_BUTTON_LEFT:
                                 if (genPath.check(mstate)) {
+                                    damagePath();
                                     Pathfinder.Nodes = AStar.euclidean(Map.Grid, Map.Start, Map.Goal, Pathfinder.MaxUp, Pathfinder.MaxDown, ASTAR_MOVE_NOBOUND);
                                     if (Pathfinder.Nodes.size() <= 1) {std::cout << "[Pathfinding] No path found\n";}
                                     else {
                                         std::cout << "[Path] Path found\n";
-                                        madeChanges = true;
+                                        damagePath();
                                     }
+#if ASTAR_RECORD
+                                    const unsigned long int reopened = Pathfinder.Recorder.countType(ASTAR_EVENT_REOPEN);
+                                    std::cout << "[Path] Expanded " << Pathfinder.Recorder.getCount() - reopened << " cells, reopened " << reopened;
+                                    if (Pathfinder.Recorder.getDropped() > 0) {std::cout << " (" << Pathfinder.Recorder.getDropped() << " events past the recorder's capacity)";}
+                                    std::cout << "\n";
+                                    if (Pathfinder.ShowHeat) {damageMap();}
+#endif
                                 } else if (placeStart.check(mstate)) {
                                     drawMode = 1;
                                 } else if (placeGoal.check(mstate)) {
                                     drawMode = 2;
                                 } else if (gridReset.check(mstate)) {
+                                    Map.History.capture(Map.Grid, 0, 0, Map.Grid.size() - 1, Map.Dims.x - 1);
                                     for (unsigned long int i = 0; i < Map.Grid.size(); i++) {
                                         for (unsigned long int j = 0; j < Map.Grid.at(i).size(); j++) {
                                             Map.Grid[i][j] = Map.MinVal;
                                         }
                                     }
+                                    Map.History.commit(Map.Grid);
+                                    Map.Pyramid.build(Map.Grid);
                                     std::cout << "[Grid] Grid cleared\n";
-                                    madeChanges = true;
+                                    damageMap();
                                 } else {
                                     for (unsigned long int i = 0; i < 14; i++) {
                                         if (increments[i].check(mstate)) {
@@ -206,11 +484,13 @@ int main(int argc, char* args[]) {
                                                 case 0:
                                                     Pathfinder.MaxUp += 1.0;
                                                     std::cout << "[Path] Increased upwards mobility - now " << Pathfinder.MaxUp << "\n";
+                                                    markSteep();
                                                     break;
                                                 case 1:
                                                     Pathfinder.MaxUp -= 1.0;
                                                     if (Pathfinder.MaxUp < 0) {Pathfinder.MaxUp = 0;}
                                                     else {std::cout << "[Path] Decreased upwards mobility - now " << Pathfinder.MaxUp << "\n";}
+                                                    markSteep();
                                                     break;
                                                 case 2:
                                                     Pathfinder.MaxDown += 1.0;
@@ -223,39 +503,39 @@ int main(int argc, char* args[]) {
                                                     break;
                                                 case 4:
                                                     Map.SizeIndex++;
+                                                    Terrain.Generator.cancel();
                                                     if (Map.SizeIndex > 14) {Map.SizeIndex = 14;}
 
                                                     Map.Dims = {720 / Map.CellSizes[Map.SizeIndex], 576 / Map.CellSizes[Map.SizeIndex]};
                                                     Map.Start = std::make_pair(0, 0);
                                                     Map.Goal = std::make_pair(Map.Dims.y - 1, Map.Dims.x - 1);
 
-                                                    Map.Grid.clear();
-                                                    for (int i = 0; i < Map.Dims.y; i++) {
-                                                        Map.Grid.emplace_back();
-                                                        for (int j = 0; j < Map.Dims.x; j++) {
-                                                            Map.Grid[i].emplace_back(Map.MinVal);
-                                                        }
-                                                    }
+                                                    resampleGrid(Map.Grid, Map.Dims.x, Map.Dims.y, Map.MinVal);
+                                                    Map.Pyramid.build(Map.Grid);
+                                                    Map.History.clear();
+                                                    Map.Zoom = Map.CellSizes[Map.SizeIndex];
+                                                    Map.ViewRow = 0.0;
+                                                    Map.ViewCol = 0.0;
                                                     Pathfinder.Nodes.clear();
-                                                    std::cout << "[Grid] Grid Cleared; Increased cell size - now " << Map.CellSizes[Map.SizeIndex] << " (" << Map.Dims.x << " x " << Map.Dims.y << ")\n";
+                                                    std::cout << "[Grid] Grid resampled; Increased cell size - now " << Map.CellSizes[Map.SizeIndex] << " (" << Map.Dims.x << " x " << Map.Dims.y << ")\n";
                                                     break;
                                                 case 5:
                                                     Map.SizeIndex--;
+                                                    Terrain.Generator.cancel();
                                                     if (Map.SizeIndex < 0) {Map.SizeIndex = 0;}
 
                                                     Map.Dims = {720 / Map.CellSizes[Map.SizeIndex], 576 / Map.CellSizes[Map.SizeIndex]};
                                                     Map.Start = std::make_pair(0, 0);
                                                     Map.Goal = std::make_pair(Map.Dims.y - 1, Map.Dims.x - 1);
 
-                                                    Map.Grid.clear();
-                                                    for (int i = 0; i < Map.Dims.y; i++) {
-                                                        Map.Grid.emplace_back();
-                                                        for (int j = 0; j < Map.Dims.x; j++) {
-                                                            Map.Grid[i].emplace_back(Map.MinVal);
-                                                        }
-                                                    }
+                                                    resampleGrid(Map.Grid, Map.Dims.x, Map.Dims.y, Map.MinVal);
+                                                    Map.Pyramid.build(Map.Grid);
+                                                    Map.History.clear();
+                                                    Map.Zoom = Map.CellSizes[Map.SizeIndex];
+                                                    Map.ViewRow = 0.0;
+                                                    Map.ViewCol = 0.0;
                                                     Pathfinder.Nodes.clear();
-                                                    std::cout << "[Grid] Grid Cleared; Decreased cell size - now " << Map.CellSizes[Map.SizeIndex] << " (" << Map.Dims.x << " x " << Map.Dims.y << ")\n";
+                                                    std::cout << "[Grid] Grid resampled; Decreased cell size - now " << Map.CellSizes[Map.SizeIndex] << " (" << Map.Dims.x << " x " << Map.Dims.y << ")\n";
                                                     break;
                                                 case 6:
                                                     Map.MinVal += 1.0;
@@ -294,7 +574,9 @@ int main(int argc, char* args[]) {
                                                     else {std::cout << "[Tool] Decreased strength - now " << Tool.Strength << "\n";}
                                                     break;
                                             }
-                                            madeChanges = true;
+                                            Window.damage(250, valueLabels[i / 2] + 20, 364, 40);
+                                            // Cell size, min & max all change how the map is drawn
+                                            if (i >= 4 && i <= 9) {damageMap();}
                                             break;
                                         }
                                     }
@@ -303,31 +585,53 @@ int main(int argc, char* args[]) {
                                 if (map.check(mstate)) {
                                     switch (drawMode) {
                                         case 0:
-                                            Map.Grid = brushGrid(Map.Grid, Map.Pos.y, Map.Pos.x, Tool.Strength, Tool.Radius, Map.MaxVal, Map.MinVal);
+                                            beginStroke(Tool.Strength);
                                             break;
                                         case 1:
+                                            if (Map.Pos.x < 0 || Map.Pos.x >= Map.Dims.x || Map.Pos.y < 0 || Map.Pos.y >= Map.Dims.y) {break;}
+                                            damagePath();
                                             Map.Start = std::make_pair(Map.Pos.y, Map.Pos.x);
+                                            damagePath();
                                             std::cout << "[Grid] Start moved to " << Map.Start.first << ", " << Map.Start.second << "\n";
                                             break;
                                         case 2:
+                                            if (Map.Pos.x < 0 || Map.Pos.x >= Map.Dims.x || Map.Pos.y < 0 || Map.Pos.y >= Map.Dims.y) {break;}
+                                            damagePath();
                                             Map.Goal = std::make_pair(Map.Pos.y, Map.Pos.x);
+                                            damagePath();
                                             std::cout << "[Grid] Goal moved to " << Map.Goal.first << ", " << Map.Goal.second << "\n";
                                             break;
                                     }
                                     drawMode = 0;
-                                    madeChanges = true;
                                 }
                                 break;
                             case SDL_BUTTON_RIGHT:
                                 if (map.check(mstate)) {
-                                    Map.Grid = brushGrid(Map.Grid, Map.Pos.y, Map.Pos.x, -Tool.Strength, Tool.Radius, Map.MaxVal, Map.MinVal);
-                                    madeChanges = true;
+                                    beginStroke(-Tool.Strength);
                                 }
                                 break;
                         }
                         break;
+                    case SDL_MOUSEWHEEL:
+                        if (map.check(mstate) && Event.wheel.y != 0) {
+                            // Zoom around the cell under the cursor
+                            const double anchorCol = Map.ViewCol + (mstate.PosR.x - Map.Offset.x) / Map.Zoom, anchorRow = Map.ViewRow + (mstate.PosR.y - Map.Offset.y) / Map.Zoom;
+                            Map.Zoom = btils::clamp<double>(Map.Zoom * (Event.wheel.y > 0 ? 1.25 : 0.8), Map.ZoomMin, Map.ZoomMax);
+                            Map.ViewCol = anchorCol - (mstate.PosR.x - Map.Offset.x) / Map.Zoom;
+                            Map.ViewRow = anchorRow - (mstate.PosR.y - Map.Offset.y) / Map.Zoom;
+                            damageMap();
+                        }
+                        break;
                     case SDL_MOUSEBUTTONUP:
                         mstate.Pressed[Event.button.button] = false;
+                        if (Event.button.button == SDL_BUTTON_LEFT || Event.button.button == SDL_BUTTON_RIGHT) {
+                            endStroke();
+                        }
+                        break;
+                    case SDL_KEYUP:
+                        if (Event.key.keysym.scancode == Keybinds.HardBrush || Event.key.keysym.scancode == Keybinds.HardErase) {
+                            endStroke();
+                        }
                         break;
                 }
                 if (!running) {break;}
@@ -337,24 +641,28 @@ int main(int argc, char* args[]) {
                 break;
             }
 
-            if ((Map.Pos.x != Map.PrevPos.x) || (Map.Pos.y != Map.PrevPos.y)) {
-                Map.PrevPos = Map.Pos;
-
-                if (mstate.Pressed[SDL_BUTTON_LEFT]) {
-                    Map.Grid = brushGrid(Map.Grid, Map.Pos.y, Map.Pos.x, Tool.Strength, Tool.Radius, Map.MaxVal, Map.MinVal);
-                    madeChanges = true;
-                } else if (mstate.Pressed[SDL_BUTTON_RIGHT]) {
-                    Map.Grid = brushGrid(Map.Grid, Map.Pos.y, Map.Pos.x, -Tool.Strength, Tool.Radius, Map.MaxVal, Map.MinVal);
-                    madeChanges = true;
+            ProgressiveNoise::Level level;
+            if (Terrain.Generator.poll(level) && level.GridW == Map.Dims.x && level.GridH == Map.Dims.y) {
+                for (int i = 0; i < Map.Dims.y; i++) {
+                    const double* src = level.Values.data() + (unsigned long int)(i / level.Step) * level.W;
+                    for (int j = 0; j < Map.Dims.x; j++) {
+                        Map.Grid[i][j] = Map.MinVal + src[j / level.Step] * (Map.MaxVal - Map.MinVal);
+                    }
                 }
-                if (Keystate[Keybinds.HardBrush]) {
-                    Map.Grid = brushGrid(Map.Grid, Map.Pos.y, Map.Pos.x, Map.MaxVal, Tool.Radius, Map.MaxVal, Map.MinVal);
-                    madeChanges = true;
+                Map.Pyramid.build(Map.Grid);
+                Map.History.clear();
+                if (level.Final && !level.DX.empty()) {
+                    Pathfinder.Slope.resize(level.DX.size());
+                    for (unsigned long int i = 0; i < level.DX.size(); i++) {Pathfinder.Slope[i] = std::hypot(level.DX[i], level.DY[i]) * (Map.MaxVal - Map.MinVal);}
+                    Pathfinder.SlopeVersion = Map.Pyramid.getVersion();
+                    markSteep();
                 }
-                if (Keystate[Keybinds.HardErase]) {
-                    Map.Grid = brushGrid(Map.Grid, Map.Pos.y, Map.Pos.x, -Map.MaxVal, Tool.Radius, Map.MaxVal, Map.MinVal);
-                    madeChanges = true;
+                if (level.Final) {
+                    const NoiseStats stats = getNoiseStats(level.Values, level.W);
+                    std::cout << "[Grid] Terrain generated (mean " << stats.Mean << ", spread " << stats.StdDev << ", roughness " << stats.Roughness << ")\n";
                 }
+                Pathfinder.Nodes.clear();
+                damageMap();
             }
 
             t += dt;
@@ -362,130 +670,139 @@ int main(int argc, char* args[]) {
             mstate.Motion = false;
         }
         if (!running) {break;}
+        // Everything the mouse swept over this frame goes down in one pass
+        applyStroke();
+
+        if (Window.isDamaged()) {
+            Window.repaint([&]() {
+                Window.clear();
+
+                // Static UI; only redrawn when the window changes size
+                if (Window.beginLayer(UI_LAYER_STATIC)) {
+                    // Background
+                    for (int i = 0; i < Window.getH() / tileSize + 1; i++) {
+                        for (int j = 0; j < Window.getW() / tileSize; j++) {
+                            const SDL_Rect tileFrame = {-Window.getW_2() + j * tileSize, Window.getH_2() + (int)(tileSize * 0.375) - i * tileSize, tileSize, tileSize};
+                            Window.renderTexture(tile, tileFrame);
+                        }
+                    }
 
-        if (madeChanges) {
-            madeChanges = false;
-            Window.clear();
-
-            // Background
-            for (int i = 0; i < Window.getH() / tileSize + 1; i++) {
-                for (int j = 0; j < Window.getW() / tileSize; j++) {
-                    const SDL_Rect tileFrame = {-Window.getW_2() + j * tileSize, Window.getH_2() + (int)(tileSize * 0.375) - i * tileSize, tileSize, tileSize};
-                    Window.renderTexture(tile, tileFrame);
-                }
-            }
-
-            const SDL_Point tileOffset = {Window.getW() % tileSize, Window.getH() % tileSize};
-            for (int i = -1; i < Window.getW() / tileSize + 1; i++) {
-                for (int j = -1; j < Window.getH() / tileSize + 1; j++) {
-                    const SDL_Point p = {-Window.getW_2() + i * tileSize + tile.getCenter().x + tileOffset.x / 2, Window.getH_2() - j * tileSize - tile.getCenter().y - tileOffset.y / 2};
-                    Window.renderTexture(tile, p);
+                    const SDL_Point tileOffset = {Window.getW() % tileSize, Window.getH() % tileSize};
+                    for (int i = -1; i < Window.getW() / tileSize + 1; i++) {
+                        for (int j = -1; j < Window.getH() / tileSize + 1; j++) {
+                            const SDL_Point p = {-Window.getW_2() + i * tileSize + tile.getCenter().x + tileOffset.x / 2, Window.getH_2() - j * tileSize - tile.getCenter().y - tileOffset.y / 2};
+                            Window.renderTexture(tile, p);
+                        }
+                    }
+
+                    // Frame surrounding the grid
+                    Window.fillRectangle(-588, 340, 760, 616, PresetColors[COLOR_DARK_GRAY]);
+                    Window.fillRectangle(-583, 335, 750, 606, PresetColors[COLOR_LIGHT_GRAY]);
+                    Window.fillRectangle(-573, 325, 730, 586, PresetColors[COLOR_DARK_GRAY]);
+
+                    // Sidebar frame
+                    Window.fillRectangle(235,  322,  20, 644, PresetColors[COLOR_DARK_GRAY]);
+                    Window.fillRectangle(609,  322,  20, 644, PresetColors[COLOR_DARK_GRAY]);
+                    Window.fillRectangle(235,  322, 394,  20, PresetColors[COLOR_DARK_GRAY]);
+                    Window.fillRectangle(235,  133, 394,  15, PresetColors[COLOR_DARK_GRAY]);
+                    Window.fillRectangle(235, -118, 394,  15, PresetColors[COLOR_DARK_GRAY]);
+                    Window.fillRectangle(235, -302, 394,  20, PresetColors[COLOR_DARK_GRAY]);
+
+                    Window.fillRectangle(240,  317,  10, 634, PresetColors[COLOR_LIGHT_GRAY]);
+                    Window.fillRectangle(614,  317,  10, 634, PresetColors[COLOR_LIGHT_GRAY]);
+                    Window.fillRectangle(240,  317, 384,  10, PresetColors[COLOR_LIGHT_GRAY]);
+                    Window.fillRectangle(240,  128, 384,   5, PresetColors[COLOR_LIGHT_GRAY]);
+                    Window.fillRectangle(240, -123, 384,   5, PresetColors[COLOR_LIGHT_GRAY]);
+                    Window.fillRectangle(240, -307, 384,  10, PresetColors[COLOR_LIGHT_GRAY]);
+
+                    // Button outlines
+                    Window.fillRectangle(-632, -295, 209,  5, PresetColors[COLOR_WHITE]);
+                    Window.fillRectangle(-632, -295,   5, 45, PresetColors[COLOR_WHITE]);
+                    Window.fillRectangle(-632, -335, 209,  5, PresetColors[COLOR_WHITE]);
+                    Window.fillRectangle(-428, -295,   5, 45, PresetColors[COLOR_WHITE]);
+
+                    Window.fillRectangle(-415, -295, 209,  5, PresetColors[COLOR_WHITE]);
+                    Window.fillRectangle(-415, -295,   5, 45, PresetColors[COLOR_WHITE]);
+                    Window.fillRectangle(-415, -335, 209,  5, PresetColors[COLOR_WHITE]);
+                    Window.fillRectangle(-211, -295,   5, 45, PresetColors[COLOR_WHITE]);
+
+                    Window.fillRectangle(-198, -295, 209,  5, PresetColors[COLOR_WHITE]);
+                    Window.fillRectangle(-198, -295,   5, 45, PresetColors[COLOR_WHITE]);
+                    Window.fillRectangle(-198, -335, 209,  5, PresetColors[COLOR_WHITE]);
+                    Window.fillRectangle(   6, -295,   5, 45, PresetColors[COLOR_WHITE]);
+
+                    Window.fillRectangle( 19, -295, 209,  5, PresetColors[COLOR_WHITE]);
+                    Window.fillRectangle( 19, -295,   5, 45, PresetColors[COLOR_WHITE]);
+                    Window.fillRectangle( 19, -335, 209,  5, PresetColors[COLOR_WHITE]);
+                    Window.fillRectangle(223, -295,   5, 45, PresetColors[COLOR_WHITE]);
+
+                    // Pathfinding text
+                    Window.renderText(font, u"Generate Path", {-529, -318}, 0, PresetColors[COLOR_WHITE]);
+                    Window.renderText(font, u"Place Start", {-312, -318}, 0, PresetColors[COLOR_WHITE]);
+                    Window.renderText(font, u"Place Goal", {-95, -318}, 0, PresetColors[COLOR_WHITE]);
+                    Window.renderText(font, u"Reset Grid", {123, -318}, 0, PresetColors[COLOR_WHITE]);
+
+                    // Section titles
+                    Window.renderText(font, u"Path Settings:", {373, 279}, 0, PresetColors[COLOR_WHITE]);
+                    Window.renderText(font, u"Grid Settings:", {373, 95}, 0, PresetColors[COLOR_WHITE]);
+                    Window.renderText(font, u"Tool Settings:", {373, -157}, 0, PresetColors[COLOR_WHITE]);
+
+                    // Increment/Decrement buttons
+                    arrowButton.setAngle(0);
+                    Window.renderTexture(arrowButton, 509,  247);
+                    Window.renderTexture(arrowButton, 509,  180);
+                    Window.renderTexture(arrowButton, 509,   63);
+                    Window.renderTexture(arrowButton, 509,   -4);
+                    Window.renderTexture(arrowButton, 509,  -71);
+                    Window.renderTexture(arrowButton, 509, -188);
+                    Window.renderTexture(arrowButton, 509, -255);
+
+                    arrowButton.setAngle(C_PI);
+                    Window.renderTexture(arrowButton, 557,  247);
+                    Window.renderTexture(arrowButton, 557,  180);
+                    Window.renderTexture(arrowButton, 557,   63);
+                    Window.renderTexture(arrowButton, 557,   -4);
+                    Window.renderTexture(arrowButton, 557,  -71);
+                    Window.renderTexture(arrowButton, 557, -188);
+                    Window.renderTexture(arrowButton, 557, -255);
+
+                    Window.endLayer();
                 }
-            }
-
-            // Frame surrounding the grid
-            Window.fillRectangle(-588, 340, 760, 616, PresetColors[COLOR_DARK_GRAY]);
-            Window.fillRectangle(-583, 335, 750, 606, PresetColors[COLOR_LIGHT_GRAY]);
-            Window.fillRectangle(-573, 325, 730, 586, PresetColors[COLOR_DARK_GRAY]);
-
-            // Sidebar frame
-            Window.fillRectangle(235,  322,  20, 644, PresetColors[COLOR_DARK_GRAY]);
-            Window.fillRectangle(609,  322,  20, 644, PresetColors[COLOR_DARK_GRAY]);
-            Window.fillRectangle(235,  322, 394,  20, PresetColors[COLOR_DARK_GRAY]);
-            Window.fillRectangle(235,  133, 394,  15, PresetColors[COLOR_DARK_GRAY]);
-            Window.fillRectangle(235, -118, 394,  15, PresetColors[COLOR_DARK_GRAY]);
-            Window.fillRectangle(235, -302, 394,  20, PresetColors[COLOR_DARK_GRAY]);
-
-            Window.fillRectangle(240,  317,  10, 634, PresetColors[COLOR_LIGHT_GRAY]);
-            Window.fillRectangle(614,  317,  10, 634, PresetColors[COLOR_LIGHT_GRAY]);
-            Window.fillRectangle(240,  317, 384,  10, PresetColors[COLOR_LIGHT_GRAY]);
-            Window.fillRectangle(240,  128, 384,   5, PresetColors[COLOR_LIGHT_GRAY]);
-            Window.fillRectangle(240, -123, 384,   5, PresetColors[COLOR_LIGHT_GRAY]);
-            Window.fillRectangle(240, -307, 384,  10, PresetColors[COLOR_LIGHT_GRAY]);
-
-            // Button outlines
-            Window.fillRectangle(-632, -295, 209,  5, PresetColors[COLOR_WHITE]);
-            Window.fillRectangle(-632, -295,   5, 45, PresetColors[COLOR_WHITE]);
-            Window.fillRectangle(-632, -335, 209,  5, PresetColors[COLOR_WHITE]);
-            Window.fillRectangle(-428, -295,   5, 45, PresetColors[COLOR_WHITE]);
-
-            Window.fillRectangle(-415, -295, 209,  5, PresetColors[COLOR_WHITE]);
-            Window.fillRectangle(-415, -295,   5, 45, PresetColors[COLOR_WHITE]);
-            Window.fillRectangle(-415, -335, 209,  5, PresetColors[COLOR_WHITE]);
-            Window.fillRectangle(-211, -295,   5, 45, PresetColors[COLOR_WHITE]);
-
-            Window.fillRectangle(-198, -295, 209,  5, PresetColors[COLOR_WHITE]);
-            Window.fillRectangle(-198, -295,   5, 45, PresetColors[COLOR_WHITE]);
-            Window.fillRectangle(-198, -335, 209,  5, PresetColors[COLOR_WHITE]);
-            Window.fillRectangle(   6, -295,   5, 45, PresetColors[COLOR_WHITE]);
-
-            Window.fillRectangle( 19, -295, 209,  5, PresetColors[COLOR_WHITE]);
-            Window.fillRectangle( 19, -295,   5, 45, PresetColors[COLOR_WHITE]);
-            Window.fillRectangle( 19, -335, 209,  5, PresetColors[COLOR_WHITE]);
-            Window.fillRectangle(223, -295,   5, 45, PresetColors[COLOR_WHITE]);
-
-            // Pathfinding text
-            Window.renderText(font, u"Generate Path", {-529, -318}, 0, PresetColors[COLOR_WHITE]);
-            Window.renderText(font, u"Place Start", {-312, -318}, 0, PresetColors[COLOR_WHITE]);
-            Window.renderText(font, u"Place Goal", {-95, -318}, 0, PresetColors[COLOR_WHITE]);
-            Window.renderText(font, u"Reset Grid", {123, -318}, 0, PresetColors[COLOR_WHITE]);
-
-            // Path Settings text
-            Window.renderText(font, u"Path Settings:", {373, 279}, 0, PresetColors[COLOR_WHITE]);
-            Window.renderText(font, (u"Up:   " + btils::to_u16string<std::string>(btils::tstr_AddZeros<int>(Pathfinder.MaxUp, 4, 3, false))).c_str(), {373, 232}, 0, PresetColors[COLOR_WHITE]);
-            Window.renderText(font, (u"Down: " + btils::to_u16string<std::string>(btils::tstr_AddZeros<int>(Pathfinder.MaxDown, 4, 3, false))).c_str(), {373, 165}, 0, PresetColors[COLOR_WHITE]);
-
-            // Grid Settings text
-            Window.renderText(font, u"Grid Settings:", {373, 95}, 0, PresetColors[COLOR_WHITE]);
-            Window.renderText(font, (u"Cell Size: " + btils::to_u16string<std::string>(btils::tstr_Length<int>(Map.CellSizes[Map.SizeIndex], 3, false, false))).c_str(), {373, 48}, 0, PresetColors[COLOR_WHITE]);
-            Window.renderText(font, (u"Min:  " + btils::to_u16string<std::string>(btils::tstr_AddZeros<int>(Map.MinVal, 4, 3, false))).c_str(), {373, -20}, 0, PresetColors[COLOR_WHITE]);
-            Window.renderText(font, (u"Max:  " + btils::to_u16string<std::string>(btils::tstr_AddZeros<int>(Map.MaxVal, 4, 3, false))).c_str(), {373, -87}, 0, PresetColors[COLOR_WHITE]);
-
-            // Tool Settings text
-            Window.renderText(font, u"Tool Settings:", {373, -157}, 0, PresetColors[COLOR_WHITE]);
-            Window.renderText(font, (u"Size:      " + btils::to_u16string<std::string>(btils::tstr_Length<int>(Tool.Radius, 3, false, false))).c_str(), {373, -204}, 0, PresetColors[COLOR_WHITE]);
-            Window.renderText(font, (u"Strength:  " + btils::to_u16string<std::string>(btils::tstr_Length<int>(Tool.Strength, 3, false, false))).c_str(), {373, -271}, 0, PresetColors[COLOR_WHITE]);
-
-            // Increment/Decrement buttons
-            arrowButton.setAngle(0);
-            Window.renderTexture(arrowButton, 509,  247);
-            Window.renderTexture(arrowButton, 509,  180);
-            Window.renderTexture(arrowButton, 509,   63);
-            Window.renderTexture(arrowButton, 509,   -4);
-            Window.renderTexture(arrowButton, 509,  -71);
-            Window.renderTexture(arrowButton, 509, -188);
-            Window.renderTexture(arrowButton, 509, -255);
-
-            arrowButton.setAngle(C_PI);
-            Window.renderTexture(arrowButton, 557,  247);
-            Window.renderTexture(arrowButton, 557,  180);
-            Window.renderTexture(arrowButton, 557,   63);
-            Window.renderTexture(arrowButton, 557,   -4);
-            Window.renderTexture(arrowButton, 557,  -71);
-            Window.renderTexture(arrowButton, 557, -188);
-            Window.renderTexture(arrowButton, 557, -255);
-
-            // Grid
-            for (unsigned long int i = 0; i < Map.Grid.size(); i++) {
-                for (unsigned long int j = 0; j < Map.Grid.at(i).size(); j++) {
-                    const unsigned char shade = 255 - btils::map<double, unsigned char>(Map.Grid.at(i).at(j), Map.MinVal, Map.MaxVal, 0, 255);
-                    Window.fillRectangle(-Window.getW_2() + j * Map.CellSizes[Map.SizeIndex] + Map.Offset.x, Window.getH_2() - i * Map.CellSizes[Map.SizeIndex] - Map.Offset.y, Map.CellSizes[Map.SizeIndex], Map.CellSizes[Map.SizeIndex], {shade, shade, shade, 255});
+                Window.renderLayer(UI_LAYER_STATIC);
+
+                // Setting values
+                Window.renderText(font, (u"Up:   " + btils::to_u16string<std::string>(btils::tstr_AddZeros<int>(Pathfinder.MaxUp, 4, 3, false))).c_str(), {373, 232}, 0, PresetColors[COLOR_WHITE]);
+                Window.renderText(font, (u"Down: " + btils::to_u16string<std::string>(btils::tstr_AddZeros<int>(Pathfinder.MaxDown, 4, 3, false))).c_str(), {373, 165}, 0, PresetColors[COLOR_WHITE]);
+                Window.renderText(font, (u"Cell Size: " + btils::to_u16string<std::string>(btils::tstr_Length<int>(Map.CellSizes[Map.SizeIndex], 3, false, false))).c_str(), {373, 48}, 0, PresetColors[COLOR_WHITE]);
+                Window.renderText(font, (u"Min:  " + btils::to_u16string<std::string>(btils::tstr_AddZeros<int>(Map.MinVal, 4, 3, false))).c_str(), {373, -20}, 0, PresetColors[COLOR_WHITE]);
+                Window.renderText(font, (u"Max:  " + btils::to_u16string<std::string>(btils::tstr_AddZeros<int>(Map.MaxVal, 4, 3, false))).c_str(), {373, -87}, 0, PresetColors[COLOR_WHITE]);
+                Window.renderText(font, (u"Size:      " + btils::to_u16string<std::string>(btils::tstr_Length<int>(Tool.Radius, 3, false, false))).c_str(), {373, -204}, 0, PresetColors[COLOR_WHITE]);
+                Window.renderText(font, (u"Strength:  " + btils::to_u16string<std::string>(btils::tstr_Length<int>(Tool.Strength, 3, false, false))).c_str(), {373, -271}, 0, PresetColors[COLOR_WHITE]);
+
+                // Grid
+                Window.renderHeightView(Map.Pyramid, Map.Grid, Map.ViewRow, Map.ViewCol, Map.Zoom, Map.MinVal, Map.MaxVal, {-Window.getW_2() + Map.Offset.x, Window.getH_2() - Map.Offset.y, 720, 576});
+
+                if (Pathfinder.ShowSteep && Pathfinder.SlopeVersion == Map.Pyramid.getVersion()) {Window.renderCellMask(Pathfinder.Steep, Map.Dims.x, Map.Dims.y, Pathfinder.SteepSerial, Map.ViewRow, Map.ViewCol, Map.Zoom, {-Window.getW_2() + Map.Offset.x, Window.getH_2() - Map.Offset.y, 720, 576}, {255, 64, 0, 120});}
+#if ASTAR_RECORD
+                if (Pathfinder.ShowHeat) {Window.renderSearchHeat(Pathfinder.Recorder, Map.ViewRow, Map.ViewCol, Map.Zoom, {-Window.getW_2() + Map.Offset.x, Window.getH_2() - Map.Offset.y, 720, 576});}
+#endif
+
+                // Path
+                Window.setClip(-Window.getW_2() + Map.Offset.x, Window.getH_2() - Map.Offset.y, 720, 576);
+                const int cellSize = std::max((int)std::ceil(Map.Zoom), 1);
+                Window.fillRectangle(viewX(Map.Start.second), viewY(Map.Start.first), cellSize, cellSize, PresetColors[COLOR_TEAL]);
+                Window.fillRectangle(viewX(Map.Goal.second), viewY(Map.Goal.first), cellSize, cellSize, PresetColors[COLOR_MAROON]);
+                for (unsigned long int i = 1; i < Pathfinder.Nodes.size(); i++) {
+                    Window.drawLine(viewX(Pathfinder.Nodes.at(i - 1).second + 0.5), viewY(Pathfinder.Nodes.at(i - 1).first + 0.5), viewX(Pathfinder.Nodes.at(i).second + 0.5), viewY(Pathfinder.Nodes.at(i).first + 0.5), PresetColors[COLOR_LIME]);
                 }
-            }
-
-            // Path
-            Window.fillRectangle(-Window.getW_2() + Map.Start.second * Map.CellSizes[Map.SizeIndex] + Map.Offset.x, Window.getH_2() - Map.Start.first * Map.CellSizes[Map.SizeIndex] - Map.Offset.y, Map.CellSizes[Map.SizeIndex], Map.CellSizes[Map.SizeIndex], PresetColors[COLOR_TEAL]);
-            Window.fillRectangle(-Window.getW_2() +  Map.Goal.second * Map.CellSizes[Map.SizeIndex] + Map.Offset.x, Window.getH_2() -  Map.Goal.first * Map.CellSizes[Map.SizeIndex] - Map.Offset.y, Map.CellSizes[Map.SizeIndex], Map.CellSizes[Map.SizeIndex], PresetColors[COLOR_MAROON]);
-            for (unsigned long int i = 1; i < Pathfinder.Nodes.size(); i++) {
-                Window.drawLine(-Window.getW_2() + Map.CellSizes[Map.SizeIndex] / 2 + Pathfinder.Nodes.at(i - 1).second * Map.CellSizes[Map.SizeIndex] + Map.Offset.x, Window.getH_2() - Map.CellSizes[Map.SizeIndex] / 2 - Pathfinder.Nodes.at(i - 1).first  * Map.CellSizes[Map.SizeIndex] - Map.Offset.y, -Window.getW_2() + Map.CellSizes[Map.SizeIndex] / 2 + Pathfinder.Nodes.at(i).second * Map.CellSizes[Map.SizeIndex] + Map.Offset.x, Window.getH_2() - Map.CellSizes[Map.SizeIndex] / 2 - Pathfinder.Nodes.at(i).first * Map.CellSizes[Map.SizeIndex] - Map.Offset.y, PresetColors[COLOR_LIME]);
-            }
-
-            Window.show();
+                Window.resetClip();
+            });
         }
 
         if ((frameTicks = SDL_GetTicks() - startTicks) < 1000 / Window.getRefreshRate()) {SDL_Delay(1000 / Window.getRefreshRate() - frameTicks);}
     }
 
+    Window.releaseFont(font);
     TTF_CloseFont(font);
 
     TTF_Quit();